@@ -6,14 +6,15 @@ use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
 use pabi::chess::position::Position;
 use shakmaty::{CastlingMode, Chess, Position as ShakmatyPosition};
 
-// TODO: Add Throughput.
 fn parse(c: &mut Criterion) {
     let positions = fs::read_to_string(concat!(env!("CARGO_MANIFEST_DIR"), "/data/positions.fen"))
         .unwrap()
         .lines()
         .map(|line| line.to_string())
         .collect::<Vec<_>>();
-    c.bench_with_input(
+    let mut group = c.benchmark_group("Position parsing");
+    group.throughput(criterion::Throughput::Elements(positions.len() as u64));
+    group.bench_with_input(
         BenchmarkId::new(
             "stockfish books",
             format!("{} arbitrary positions", positions.len()),
@@ -28,12 +29,37 @@ fn parse(c: &mut Criterion) {
             });
         },
     );
+    group.finish();
+}
+
+// Streams the corpus straight out of the memory-mapped file: this is the
+// path the bulk training/benchmarking loaders take and is expected to beat
+// per-line parsing by a wide margin.
+fn parse_corpus(c: &mut Criterion) {
+    let corpus =
+        pabi::util::Corpus::open(concat!(env!("CARGO_MANIFEST_DIR"), "/data/positions.fen"))
+            .unwrap();
+    let total = corpus.positions().count();
+    let mut group = c.benchmark_group("Position parsing");
+    group.throughput(criterion::Throughput::Elements(total as u64));
+    group.bench_with_input(
+        BenchmarkId::new("mmap corpus", format!("{total} arbitrary positions")),
+        &corpus,
+        |b, corpus| {
+            b.iter(|| {
+                for position in corpus.positions() {
+                    criterion::black_box(position.unwrap());
+                }
+            });
+        },
+    );
+    group.finish();
 }
 
 criterion_group! {
     name = position_parsing;
     config = Criterion::default().sample_size(10);
-    targets = parse
+    targets = parse, parse_corpus
 }
 
 fn generate_moves(positions: &[Position]) {
@@ -42,7 +68,6 @@ fn generate_moves(positions: &[Position]) {
     }
 }
 
-// TODO: Add Throughput.
 fn movegen_bench(c: &mut Criterion) {
     let mut group = c.benchmark_group("Move generation");
     let mut positions = vec![];
@@ -74,7 +99,7 @@ fn movegen_bench(c: &mut Criterion) {
         .lines()
     {
         let shakmaty_setup: shakmaty::fen::Fen = line.parse().unwrap();
-        shakmaty_positions.push(shakmaty_setup.position(CastlingMode::Standard).unwrap());
+        shakmaty_positions.push(shakmaty_setup.into_position(CastlingMode::Standard).unwrap());
     }
     group.throughput(criterion::Throughput::Elements(
         shakmaty_positions.len() as u64
@@ -96,10 +121,79 @@ fn movegen_bench(c: &mut Criterion) {
     group.finish();
 }
 
+// Generation cost differs wildly between position classes: sliders dominate
+// open positions, pin/check handling dominates the rest. Benchmarking one
+// representative per class localizes a regression to its code path instead
+// of diluting it over an arbitrary corpus.
+fn movegen_by_class_bench(c: &mut Criterion) {
+    let mut group = c.benchmark_group("Move generation by class");
+    for (class, fen) in [
+        (
+            "open middlegame",
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        ),
+        (
+            "closed middlegame",
+            "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        ),
+        ("endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"),
+        (
+            "in check",
+            "rnbqkbnr/ppp1pppp/8/1B1p4/4P3/8/PPPP1PPP/RNBQK1NR b KQkq - 1 2",
+        ),
+    ] {
+        let position = Position::from_fen(fen).unwrap();
+        group.bench_with_input(BenchmarkId::new("movegen", class), &position, |b, position| {
+            b.iter(|| criterion::black_box(position.generate_moves()));
+        });
+    }
+    group.finish();
+}
+
 criterion_group! {
     name = movegen;
     config = Criterion::default().sample_size(100);
-    targets = movegen_bench
+    targets = movegen_bench, movegen_by_class_bench
+}
+
+// Makes and immediately unmakes every legal move of every corpus position:
+// the hot loop of any search. Throughput is reported per move, so the number
+// is directly comparable between runs even if the corpus changes.
+fn make_unmake_bench(c: &mut Criterion) {
+    let mut positions = vec![];
+    for line in fs::read_to_string(concat!(env!("CARGO_MANIFEST_DIR"), "/data/positions.fen"))
+        .unwrap()
+        .lines()
+    {
+        positions.push(Position::try_from(line).unwrap());
+    }
+    let moves: Vec<_> = positions.iter().map(Position::generate_moves).collect();
+    let total: u64 = moves.iter().map(|list| list.len() as u64).sum();
+    let mut group = c.benchmark_group("Make move");
+    group.throughput(criterion::Throughput::Elements(total));
+    group.bench_function(
+        BenchmarkId::new(
+            "make_unmake roundtrip",
+            format!("{} moves over {} positions", total, positions.len()),
+        ),
+        |b| {
+            b.iter(|| {
+                for (position, moves) in positions.iter_mut().zip(&moves) {
+                    for next_move in moves.iter() {
+                        position.make_move(next_move);
+                        position.unmake_move();
+                    }
+                }
+            });
+        },
+    );
+    group.finish();
+}
+
+criterion_group! {
+    name = make_move;
+    config = Criterion::default().sample_size(20);
+    targets = make_unmake_bench
 }
 
 // This acts both as performance and correctness test.
@@ -107,7 +201,6 @@ fn perft_bench(c: &mut Criterion) {
     let mut group = c.benchmark_group("perft");
     // TODO: Abstract this out and have a single array/dataset of perft positions to
     // check. Inlining these is quite unappealing.
-    // TODO: Add Throughput - it should be the number of nodes.
     for (position, depth, nodes) in [
         // Position 1.
         (Position::starting(), 5, 4865609),
@@ -178,4 +271,4 @@ criterion_group! {
     targets = perft_bench
 }
 
-criterion_main!(position_parsing, movegen, perft);
+criterion_main!(position_parsing, movegen, make_move, perft);
@@ -0,0 +1,93 @@
+//! Self-play training data generator: plays games in parallel and writes
+//! sharded binary records (see `pabi::training::data` for the format).
+//! Standalone by default; `--serve` turns the process into a cluster
+//! coordinator and `--connect` into a worker feeding one.
+//!
+//! ```text
+//! generate [--games N] [--workers N] [--simulations N] [--max-plies N]
+//!          [--positions FILE] [--output DIR]
+//!          [--serve ADDR | --connect ADDR]
+//! ```
+
+use std::path::PathBuf;
+use std::process::exit;
+use std::time::Instant;
+
+use pabi::chess::position::Position;
+use pabi::training::cluster;
+use pabi::training::selfplay::{self, Config};
+use pabi::util::Corpus;
+
+fn main() -> anyhow::Result<()> {
+    let mut config = Config::default();
+    let mut positions_file: Option<PathBuf> = None;
+    let mut output = PathBuf::from("data/selfplay");
+    let mut serve = None;
+    let mut connect = None;
+    let mut args = std::env::args().skip(1);
+    while let Some(flag) = args.next() {
+        let Some(value) = args.next() else {
+            usage(&format!("{flag} requires a value"));
+        };
+        match flag.as_str() {
+            "--games" => config.games = parse(&flag, &value),
+            "--workers" => config.workers = parse(&flag, &value),
+            "--simulations" => config.simulations = parse(&flag, &value),
+            "--max-plies" => config.max_plies = parse(&flag, &value),
+            "--positions" => positions_file = Some(PathBuf::from(value)),
+            "--output" => output = PathBuf::from(value),
+            "--serve" => serve = Some(parse_address(&flag, &value)),
+            "--connect" => connect = Some(parse_address(&flag, &value)),
+            _ => usage(&format!("unknown flag {flag}")),
+        }
+    }
+    let starts: Vec<Position> = match &positions_file {
+        Some(path) => Corpus::open(path)?
+            .positions()
+            .collect::<anyhow::Result<_>>()?,
+        None => Vec::new(),
+    };
+    let start = Instant::now();
+    match (serve, connect) {
+        (Some(_), Some(_)) => usage("--serve and --connect are mutually exclusive"),
+        (Some(address), None) => {
+            let shards = cluster::coordinate(address, config.games, &output)?;
+            println!("{} games in {} shards in {:.1?}", config.games, shards, start.elapsed());
+        },
+        (None, Some(address)) => cluster::work(address, &config, &starts)?,
+        (None, None) => {
+            let summary = selfplay::generate(&config, &starts, &output)?;
+            let elapsed = start.elapsed();
+            println!(
+                "{} games, {} positions, {} shards in {:.1?} ({:.0} positions/s)",
+                summary.games,
+                summary.plies,
+                summary.shards,
+                elapsed,
+                summary.plies as f64 / elapsed.as_secs_f64().max(f64::EPSILON),
+            );
+        },
+    }
+    Ok(())
+}
+
+fn parse_address(flag: &str, value: &str) -> std::net::SocketAddr {
+    value
+        .parse()
+        .unwrap_or_else(|_| usage(&format!("{flag} takes host:port, got {value}")))
+}
+
+fn parse(flag: &str, value: &str) -> usize {
+    value
+        .parse()
+        .unwrap_or_else(|_| usage(&format!("{flag} takes a number, got {value}")))
+}
+
+fn usage(error: &str) -> ! {
+    eprintln!("error: {error}");
+    eprintln!(
+        "usage: generate [--games N] [--workers N] [--simulations N] [--max-plies N] \
+         [--positions FILE] [--output DIR] [--serve ADDR | --connect ADDR]"
+    );
+    exit(1);
+}
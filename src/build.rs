@@ -18,12 +18,67 @@ fn git_revision_hash() -> String {
     std::str::from_utf8(&output).unwrap().trim().to_string()
 }
 
-fn generate_file(filename: &str, contents: &str) {
+fn generate_file(filename: &str, contents: impl AsRef<[u8]>) {
     let out_dir = env::var_os("OUT_DIR").unwrap();
     let dest_path = Path::new(&out_dir).join(filename);
     fs::write(&dest_path, contents).unwrap();
 }
 
+/// Pre-calculated attack tables that are converted from the checked-in
+/// textual arrays in `generated/` into little-endian binary blobs consumed
+/// through `include_bytes!`. Parsing megabytes of array text is a measurable
+/// chunk of the compile time; the blobs are included byte-for-byte.
+const BINARY_TABLES: [&str; 11] = [
+    "rook_attacks",
+    "rook_relevant_occupancies",
+    "bishop_attacks",
+    "bishop_relevant_occupancies",
+    "rays",
+    "bishop_rays",
+    "rook_rays",
+    "knight_attacks",
+    "king_attacks",
+    "white_pawn_attacks",
+    "black_pawn_attacks",
+];
+
+/// Extracts the integer literals (decimal or `0x` hexadecimal, possibly with
+/// `_` separators) from a generated table. The surrounding Rust syntax is
+/// ignored: identifiers can not start with a digit, so any digit-leading
+/// token is a literal.
+fn parse_table(source: &str) -> Vec<u64> {
+    let mut values = Vec::new();
+    let mut token = String::new();
+    for ch in source.chars().chain(std::iter::once('\n')) {
+        if ch.is_ascii_alphanumeric() || ch == '_' {
+            token.push(ch);
+            continue;
+        }
+        if token.chars().next().map_or(false, |first| first.is_ascii_digit()) {
+            let literal = token.replace('_', "");
+            let value = match literal.strip_prefix("0x") {
+                Some(hex) => u64::from_str_radix(hex, 16).unwrap(),
+                None => literal.parse().unwrap(),
+            };
+            values.push(value);
+        }
+        token.clear();
+    }
+    values
+}
+
+fn generate_attack_tables() -> Result<(), Box<dyn Error>> {
+    for table in BINARY_TABLES {
+        let source = fs::read_to_string(Path::new("generated").join(format!("{table}.rs")))?;
+        let mut blob = Vec::new();
+        for value in parse_table(&source) {
+            blob.extend_from_slice(&value.to_le_bytes());
+        }
+        generate_file(&format!("{table}.bin"), blob);
+    }
+    Ok(())
+}
+
 fn generate_version() -> Result<(), Box<dyn Error>> {
     let mut version = String::new();
     writeln!(
@@ -40,5 +95,6 @@ fn generate_version() -> Result<(), Box<dyn Error>> {
 
 fn main() -> Result<(), Box<dyn Error>> {
     generate_version()?;
+    generate_attack_tables()?;
     Ok(())
 }
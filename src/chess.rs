@@ -4,3 +4,4 @@ pub mod attacks;
 pub mod bitboard;
 pub mod core;
 pub mod position;
+pub mod zobrist;
@@ -4,8 +4,8 @@
 // TODO: This code is probably by far the less appealing in the project.
 // Refactor it and make it nicer.
 
-use crate::chess::bitboard::{Bitboard, Pieces};
-use crate::chess::core::{Player, Square, BOARD_SIZE};
+use crate::chess::bitboard::{Bitboard, Board, Pieces};
+use crate::chess::core::{File, Piece, PieceKind, Player, Square, BOARD_SIZE};
 
 pub(super) fn king_attacks(from: Square) -> Bitboard {
     KING_ATTACKS[from as usize]
@@ -16,13 +16,21 @@ pub(super) fn queen_attacks(from: Square, occupancy: Bitboard) -> Bitboard {
 }
 
 pub(super) fn rook_attacks(from: Square, occupancy: Bitboard) -> Bitboard {
-    ROOK_ATTACKS[ROOK_ATTACK_OFFSETS[from as usize]
-        + pext(occupancy.bits(), ROOK_RELEVANT_OCCUPANCIES[from as usize]) as usize]
+    rook_table().attacks(
+        from,
+        occupancy,
+        ROOK_RELEVANT_OCCUPANCIES[from as usize],
+        ROOK_ATTACK_OFFSETS[from as usize],
+    )
 }
 
 pub(super) fn bishop_attacks(from: Square, occupancy: Bitboard) -> Bitboard {
-    BISHOP_ATTACKS[BISHOP_ATTACK_OFFSETS[from as usize]
-        + pext(occupancy.bits(), BISHOP_RELEVANT_OCCUPANCIES[from as usize]) as usize]
+    bishop_table().attacks(
+        from,
+        occupancy,
+        BISHOP_RELEVANT_OCCUPANCIES[from as usize],
+        BISHOP_ATTACK_OFFSETS[from as usize],
+    )
 }
 
 pub(super) fn knight_attacks(square: Square) -> Bitboard {
@@ -36,6 +44,19 @@ pub(super) fn pawn_attacks(square: Square, player: Player) -> Bitboard {
     }
 }
 
+/// Squares from which a pawn of `player` attacks `square`: the mirror of
+/// [`pawn_attacks`]. This is computed from shifts instead of the tables
+/// because the tables have no entries for backrank squares (a pawn can never
+/// stand there), while a king or a capture target on rank 1/8 can still be
+/// attacked by a pawn.
+pub(super) fn pawn_attackers(square: Square, player: Player) -> Bitboard {
+    let target = Bitboard::from(square);
+    match player {
+        Player::White => ((target >> 7) & !File::A.mask()) | ((target >> 9) & !File::H.mask()),
+        Player::Black => ((target << 7) & !File::H.mask()) | ((target << 9) & !File::A.mask()),
+    }
+}
+
 pub(super) fn ray(from: Square, to: Square) -> Bitboard {
     RAYS[(from as usize) * (BOARD_SIZE as usize) + to as usize]
 }
@@ -48,7 +69,12 @@ fn rook_ray(from: Square, to: Square) -> Bitboard {
     ROOK_RAYS[(from as usize) * (BOARD_SIZE as usize) + to as usize]
 }
 
-// TODO: Document.
+// Extracts the bits of `a` selected by `mask` ([Parallel Bits Extract]).
+// Compiles to a single instruction when BMI2 is available; the software
+// fallback is only used while building the magic tables, where its cost does
+// not matter.
+//
+// [Parallel Bits Extract]: https://www.chessprogramming.org/BMI2#PEXT
 fn pext(a: u64, mask: u64) -> u64 {
     if cfg!(target_feature = "bmi2") {
         unsafe { core::arch::x86_64::_pext_u64(a, mask) }
@@ -68,6 +94,175 @@ fn pext(a: u64, mask: u64) -> u64 {
     }
 }
 
+/// Cache-compacted slider attack table built once at startup from the
+/// canonical PEXT-ordered data in `generated/`.
+///
+/// The raw rook table stores 102,400 [Bitboard]s (800 KiB), but only a few
+/// thousand of them are distinct: every attack set is determined by the first
+/// blocker on each ray, and most blocker configurations produce the same set.
+/// Storing 16-bit indices into the deduplicated sets shrinks the hot lookup
+/// working set to ~200 KiB for rooks and ~10 KiB for bishops, which fits L2
+/// comfortably and cuts cache misses in the movegen loop.
+///
+/// The per-occupancy index is computed by PEXT where BMI2 is fast and by
+/// [Fancy Magic Bitboards] otherwise (the pre-BMI2 generation and AMD Zen
+/// 1/2, where PEXT is microcoded and an order of magnitude slower than a
+/// multiply). The dispatch is resolved at compile time; on non-BMI2 builds
+/// the magic factors are found by a deterministic random search and the index
+/// slots are permuted accordingly, so both paths share one source of table
+/// data.
+///
+/// [Fancy Magic Bitboards]: https://www.chessprogramming.org/Magic_Bitboards#Fancy
+struct SliderTable {
+    // Unused (zeroed) on BMI2 builds.
+    magics: [u64; BOARD_SIZE as usize],
+    shifts: [u32; BOARD_SIZE as usize],
+    indices: Vec<u16>,
+    unique: Vec<Bitboard>,
+}
+
+impl SliderTable {
+    fn new(
+        reference: &[Bitboard],
+        offsets: &[usize; BOARD_SIZE as usize],
+        masks: &[u64; BOARD_SIZE as usize],
+    ) -> Self {
+        let mut result = Self {
+            magics: [0; BOARD_SIZE as usize],
+            shifts: [0; BOARD_SIZE as usize],
+            indices: Vec::new(),
+            unique: Vec::new(),
+        };
+        // The full per-occupancy table in the slot order the lookup will use:
+        // canonical PEXT order on BMI2 builds, magic-permuted otherwise.
+        let mut slots = reference.to_vec();
+        if !cfg!(target_feature = "bmi2") {
+            result.find_magics(&mut slots, reference, offsets, masks);
+        }
+        result.compress(&slots);
+        result
+    }
+
+    /// Replaces `slots` with the magic-indexed permutation of `reference` and
+    /// fills in the found magic factors.
+    fn find_magics(
+        &mut self,
+        slots: &mut [Bitboard],
+        reference: &[Bitboard],
+        offsets: &[usize; BOARD_SIZE as usize],
+        masks: &[u64; BOARD_SIZE as usize],
+    ) {
+        // xorshift64*; any fixed seed works, determinism makes startup
+        // reproducible.
+        let mut state = 0x9E37_79B9_7F4A_7C15_u64;
+        let mut random_sparse = || {
+            let mut next = || {
+                state ^= state >> 12;
+                state ^= state << 25;
+                state ^= state >> 27;
+                state.wrapping_mul(0x2545_F491_4F6C_DD1D)
+            };
+            // Sparse candidates (few set bits) are much more likely to be
+            // magic.
+            next() & next() & next()
+        };
+        for square in 0..BOARD_SIZE as usize {
+            let mask = masks[square];
+            let bits = mask.count_ones();
+            let size = 1_usize << bits;
+            let offset = offsets[square];
+            self.shifts[square] = 64 - bits;
+            // Enumerate all occupancies of the mask (carry-rippler) together
+            // with their attack sets from the canonical table.
+            let mut occupancies = Vec::with_capacity(size);
+            let mut occupancy = 0u64;
+            loop {
+                occupancies.push((occupancy, reference[offset + pext(occupancy, mask) as usize]));
+                occupancy = occupancy.wrapping_sub(mask) & mask;
+                if occupancy == 0 {
+                    break;
+                }
+            }
+            // Try random sparse candidates until one maps every occupancy to
+            // a slot without destructive collisions. This typically takes
+            // well under 100k tries per square. Slots are marked with the try
+            // number instead of being cleared between the tries.
+            let table = &mut slots[offset..offset + size];
+            let mut used = vec![0u32; size];
+            let mut try_number = 0;
+            'search: loop {
+                let magic = random_sparse();
+                // Quick rejection: a good magic spreads the mask over the
+                // high bits.
+                if (mask.wrapping_mul(magic) >> 56).count_ones() < 6 {
+                    continue;
+                }
+                try_number += 1;
+                for &(occupancy, attacks) in &occupancies {
+                    let index = (occupancy.wrapping_mul(magic) >> (64 - bits)) as usize;
+                    if used[index] == try_number && table[index] != attacks {
+                        continue 'search;
+                    }
+                    used[index] = try_number;
+                    table[index] = attacks;
+                }
+                self.magics[square] = magic;
+                break;
+            }
+        }
+    }
+
+    /// Deduplicates the attack sets: each slot becomes a 16-bit index into
+    /// the vector of distinct sets.
+    fn compress(&mut self, slots: &[Bitboard]) {
+        let mut index_of = std::collections::HashMap::new();
+        self.indices = slots
+            .iter()
+            .map(|&attacks| {
+                *index_of.entry(attacks.bits()).or_insert_with(|| {
+                    self.unique.push(attacks);
+                    u16::try_from(self.unique.len() - 1)
+                        .expect("distinct slider attack sets should fit in 16 bits")
+                })
+            })
+            .collect();
+    }
+
+    fn attacks(&self, from: Square, occupancy: Bitboard, mask: u64, offset: usize) -> Bitboard {
+        // The dispatch is resolved at compile time: either branch is dead
+        // code on a given build.
+        let index = if cfg!(target_feature = "bmi2") {
+            pext(occupancy.bits(), mask) as usize
+        } else {
+            ((occupancy.bits() & mask).wrapping_mul(self.magics[from as usize])
+                >> self.shifts[from as usize]) as usize
+        };
+        self.unique[self.indices[offset + index] as usize]
+    }
+}
+
+fn rook_table() -> &'static SliderTable {
+    static TABLE: std::sync::OnceLock<SliderTable> = std::sync::OnceLock::new();
+    TABLE.get_or_init(|| {
+        SliderTable::new(
+            &*ROOK_ATTACKS,
+            &ROOK_ATTACK_OFFSETS,
+            &ROOK_RELEVANT_OCCUPANCIES,
+        )
+    })
+}
+
+fn bishop_table() -> &'static SliderTable {
+    static TABLE: std::sync::OnceLock<SliderTable> = std::sync::OnceLock::new();
+    TABLE.get_or_init(|| {
+        SliderTable::new(
+            &*BISHOP_ATTACKS,
+            &BISHOP_ATTACK_OFFSETS,
+            &BISHOP_RELEVANT_OCCUPANCIES,
+        )
+    })
+}
+
 #[derive(Debug)]
 pub(super) struct AttackInfo {
     pub(super) attacks: Bitboard,
@@ -79,101 +274,52 @@ pub(super) struct AttackInfo {
 }
 
 impl AttackInfo {
-    // TODO: Handle each piece separately.
     pub(super) fn new(
         they: Player,
         their: &Pieces,
         king: Square,
         our_occupancy: Bitboard,
         occupancy: Bitboard,
+        map: &AttackMap,
     ) -> Self {
         let mut result = Self {
-            attacks: Bitboard::empty(),
-            checkers: Bitboard::empty(),
+            // The aggregate attacks come straight from the incrementally
+            // maintained map instead of being recomputed piece by piece.
+            attacks: map.attacks_by(their.all()),
+            checkers: (knight_attacks(king) & their.knights)
+                | (pawn_attackers(king, they) & their.pawns),
             pins: Bitboard::empty(),
             xrays: Bitboard::empty(),
-            safe_king_squares: Bitboard::empty(),
+            safe_king_squares: !our_occupancy & king_attacks(king),
         };
-        result.safe_king_squares = !our_occupancy & king_attacks(king);
         let occupancy_without_king = occupancy - Bitboard::from(king);
-        // King.
-        let their_king = their.king.as_square();
-        result.attacks |= king_attacks(their_king);
-        // Knights.
-        for knight in their.knights.iter() {
-            let targets = knight_attacks(knight);
-            result.attacks |= targets;
-            if targets.contains(king) {
-                result.checkers.extend(knight);
-            }
-        }
-        // Pawns.
-        for pawn in their.pawns.iter() {
-            let targets = pawn_attacks(pawn, they);
-            result.attacks |= targets;
-            if targets.contains(king) {
-                result.checkers.extend(pawn);
-            }
-        }
-        // Queens.
-        // TODO: Sliders repeat each other. Pull this into a function.
-        for queen in their.queens.iter() {
-            let targets = queen_attacks(queen, occupancy);
-            result.attacks |= targets;
-            if targets.contains(king) {
-                result.checkers.extend(queen);
-                result.safe_king_squares -= queen_attacks(queen, occupancy_without_king);
-                // An attack can be either a check or a (potential) pin, not
-                // both.
-                continue;
-            }
-            let attack_ray = ray(queen, king);
-            let blocker = (attack_ray & occupancy) - Bitboard::from(queen);
-            if blocker.count() == 1 {
-                if (blocker & our_occupancy).has_any() {
-                    result.pins |= blocker;
-                } else {
-                    result.xrays |= blocker;
+        // Sliders need a per-piece pass for the king-relative state: checks
+        // (with the extra "king can not retreat along the checking ray"
+        // probe), pins and x-rays.
+        type RayFn = fn(Square, Square) -> Bitboard;
+        type SliderFn = fn(Square, Bitboard) -> Bitboard;
+        let sliders: [(Bitboard, RayFn, SliderFn); 3] = [
+            (their.queens, ray, queen_attacks),
+            (their.bishops, bishop_ray, bishop_attacks),
+            (their.rooks, rook_ray, rook_attacks),
+        ];
+        for (sliders, attack_ray_to, slider_attacks) in sliders {
+            for slider in sliders.iter() {
+                if map.of(slider).contains(king) {
+                    result.checkers.extend(slider);
+                    result.safe_king_squares -= slider_attacks(slider, occupancy_without_king);
+                    // An attack can be either a check or a (potential) pin,
+                    // not both.
+                    continue;
                 }
-            }
-        }
-        for bishop in their.bishops.iter() {
-            let targets = bishop_attacks(bishop, occupancy);
-            result.attacks |= targets;
-            if targets.contains(king) {
-                result.checkers.extend(bishop);
-                result.safe_king_squares -= bishop_attacks(bishop, occupancy_without_king);
-                // An attack can be either a check or a (potential) pin, not
-                // both.
-                continue;
-            }
-            let attack_ray = bishop_ray(bishop, king);
-            let blocker = (attack_ray & occupancy) - Bitboard::from(bishop);
-            if blocker.count() == 1 {
-                if (blocker & our_occupancy).has_any() {
-                    result.pins |= blocker;
-                } else {
-                    result.xrays |= blocker;
-                }
-            }
-        }
-        for rook in their.rooks.iter() {
-            let targets = rook_attacks(rook, occupancy);
-            result.attacks |= targets;
-            if targets.contains(king) {
-                result.checkers.extend(rook);
-                result.safe_king_squares -= rook_attacks(rook, occupancy_without_king);
-                // An attack can be either a check or a (potential) pin, not
-                // both.
-                continue;
-            }
-            let attack_ray = rook_ray(rook, king);
-            let blocker = (attack_ray & occupancy) - Bitboard::from(rook);
-            if blocker.count() == 1 {
-                if (blocker & our_occupancy).has_any() {
-                    result.pins |= blocker;
-                } else {
-                    result.xrays |= blocker;
+                let attack_ray = attack_ray_to(slider, king);
+                let blocker = (attack_ray & occupancy) - Bitboard::from(slider);
+                if blocker.count() == 1 {
+                    if (blocker & our_occupancy).has_any() {
+                        result.pins |= blocker;
+                    } else {
+                        result.xrays |= blocker;
+                    }
                 }
             }
         }
@@ -182,63 +328,196 @@ impl AttackInfo {
     }
 }
 
-// Generated in build.rs.
+/// Attack bitboards of every piece on the board, maintained incrementally by
+/// [`crate::chess::position::Position::make_move`]: a move invalidates only
+/// the attacks of the pieces on the changed squares and of the sliders whose
+/// rays pass through them, so repairing the map is much cheaper than
+/// recomputing every piece from zero. [`AttackInfo`] reads the aggregate
+/// attacks from here and evaluation features such as mobility can read the
+/// per-piece bitboards.
+#[derive(Clone)]
+pub(super) struct AttackMap {
+    /// Attacks of the piece standing on each square (empty for empty
+    /// squares), regardless of which player it belongs to.
+    by_square: [Bitboard; BOARD_SIZE as usize],
+}
+
+impl AttackMap {
+    /// Builds the map from scratch. Only used when a position is
+    /// constructed: afterwards the map is repaired incrementally.
+    pub(super) fn new(board: &Board) -> Self {
+        let mut result = Self {
+            by_square: [Bitboard::empty(); BOARD_SIZE as usize],
+        };
+        let occupancy = board.white_pieces.all() | board.black_pieces.all();
+        result.repair(board, occupancy);
+        result
+    }
+
+    /// Repairs the map after a move modified the occupancy of the `changed`
+    /// squares: the pieces standing on them and every slider whose ray
+    /// passes through them are recomputed. The affected sliders are
+    /// discovered by probing outwards from each changed square: a slider
+    /// whose attack set changed necessarily sees one of the changed squares
+    /// on the updated occupancy (the closest changed blocker on the affected
+    /// ray).
+    pub(super) fn repair(&mut self, board: &Board, changed: Bitboard) {
+        let (white, black) = (&board.white_pieces, &board.black_pieces);
+        let occupancy = white.all() | black.all();
+        let straight_sliders = white.rooks | white.queens | black.rooks | black.queens;
+        let diagonal_sliders = white.bishops | white.queens | black.bishops | black.queens;
+        let mut dirty = changed;
+        for square in changed.iter() {
+            dirty |= rook_attacks(square, occupancy) & straight_sliders;
+            dirty |= bishop_attacks(square, occupancy) & diagonal_sliders;
+        }
+        crate::stats::record(crate::stats::Event::AttackRepairs, 1);
+        crate::stats::record(
+            crate::stats::Event::AttackRepairSquares,
+            u64::from(dirty.count()),
+        );
+        for square in dirty.iter() {
+            self.by_square[square as usize] = match board.at(square) {
+                Some(piece) => piece_attacks(piece, square, occupancy),
+                None => Bitboard::empty(),
+            };
+        }
+    }
+
+    /// Returns the attacks of the piece standing on the given square (empty
+    /// if the square is empty).
+    pub(super) fn of(&self, square: Square) -> Bitboard {
+        self.by_square[square as usize]
+    }
+
+    /// Returns all squares attacked by the pieces standing on
+    /// `player_occupancy` (e.g. one side's occupancy for "every square the
+    /// opponent attacks").
+    pub(super) fn attacks_by(&self, player_occupancy: Bitboard) -> Bitboard {
+        let mut result = Bitboard::empty();
+        for square in player_occupancy.iter() {
+            result |= self.by_square[square as usize];
+        }
+        result
+    }
+}
+
+/// Attacks of a single piece from the given square.
+fn piece_attacks(piece: Piece, from: Square, occupancy: Bitboard) -> Bitboard {
+    match piece.kind {
+        PieceKind::King => king_attacks(from),
+        PieceKind::Queen => queen_attacks(from, occupancy),
+        PieceKind::Rook => rook_attacks(from, occupancy),
+        PieceKind::Bishop => bishop_attacks(from, occupancy),
+        PieceKind::Knight => knight_attacks(from),
+        PieceKind::Pawn => pawn_attacks(from, piece.owner),
+    }
+}
+
+// The tables are generated as textual Rust arrays in `generated/` (the
+// checked-in source of truth) and converted by build.rs into little-endian
+// binary blobs that are included byte-for-byte: this keeps megabytes of
+// array text out of the compiler on every build and gives explicit control
+// over the alignment of the hot data.
 // TODO: Document PEXT bitboards.
+#[cfg(not(target_endian = "little"))]
+compile_error!("attack tables are little-endian blobs; a byte-swapping load is required for big-endian targets");
+
+/// Aligns the included table to a cache line boundary.
+#[repr(C, align(64))]
+struct Aligned<T>(T);
+
+impl<T> std::ops::Deref for Aligned<T> {
+    type Target = T;
+
+    fn deref(&self) -> &T {
+        &self.0
+    }
+}
+
+macro_rules! include_table {
+    ($name:ident, $type:ty, $count:expr, $file:literal) => {
+        static $name: Aligned<[$type; $count]> = Aligned(unsafe {
+            // SAFETY: the blob is exactly $count little-endian 64-bit values
+            // and every bit pattern is a valid $type.
+            std::mem::transmute::<[u8; $count * 8], [$type; $count]>(*include_bytes!(concat!(
+                env!("OUT_DIR"),
+                "/",
+                $file
+            )))
+        });
+    };
+}
+
 const BISHOP_ATTACKS_COUNT: usize = 5248;
-const BISHOP_ATTACKS: [Bitboard; BISHOP_ATTACKS_COUNT] = include!(concat!(
-    env!("CARGO_MANIFEST_DIR"),
-    "/generated/bishop_attacks.rs"
-));
+include_table!(
+    BISHOP_ATTACKS,
+    Bitboard,
+    BISHOP_ATTACKS_COUNT,
+    "bishop_attacks.bin"
+);
 const BISHOP_ATTACK_OFFSETS: [usize; BOARD_SIZE as usize] = include!(concat!(
     env!("CARGO_MANIFEST_DIR"),
     "/generated/bishop_attack_offsets.rs"
 ));
-const BISHOP_RELEVANT_OCCUPANCIES: [u64; BOARD_SIZE as usize] = include!(concat!(
-    env!("CARGO_MANIFEST_DIR"),
-    "/generated/bishop_relevant_occupancies.rs"
-));
+include_table!(
+    BISHOP_RELEVANT_OCCUPANCIES,
+    u64,
+    BOARD_SIZE as usize,
+    "bishop_relevant_occupancies.bin"
+);
 
 const ROOK_ATTACKS_COUNT: usize = 102_400;
-const ROOK_ATTACKS: [Bitboard; ROOK_ATTACKS_COUNT] = include!(concat!(
-    env!("CARGO_MANIFEST_DIR"),
-    "/generated/rook_attacks.rs"
-));
-const ROOK_RELEVANT_OCCUPANCIES: [u64; BOARD_SIZE as usize] = include!(concat!(
-    env!("CARGO_MANIFEST_DIR"),
-    "/generated/rook_relevant_occupancies.rs"
-));
+include_table!(ROOK_ATTACKS, Bitboard, ROOK_ATTACKS_COUNT, "rook_attacks.bin");
+include_table!(
+    ROOK_RELEVANT_OCCUPANCIES,
+    u64,
+    BOARD_SIZE as usize,
+    "rook_relevant_occupancies.bin"
+);
 const ROOK_ATTACK_OFFSETS: [usize; BOARD_SIZE as usize] = include!(concat!(
     env!("CARGO_MANIFEST_DIR"),
     "/generated/rook_attack_offsets.rs"
 ));
 
-const RAYS: [Bitboard; BOARD_SIZE as usize * BOARD_SIZE as usize] =
-    include!(concat!(env!("CARGO_MANIFEST_DIR"), "/generated/rays.rs"));
-const BISHOP_RAYS: [Bitboard; BOARD_SIZE as usize * BOARD_SIZE as usize] = include!(concat!(
-    env!("CARGO_MANIFEST_DIR"),
-    "/generated/bishop_rays.rs"
-));
-const ROOK_RAYS: [Bitboard; BOARD_SIZE as usize * BOARD_SIZE as usize] = include!(concat!(
-    env!("CARGO_MANIFEST_DIR"),
-    "/generated/rook_rays.rs"
-));
+include_table!(
+    RAYS,
+    Bitboard,
+    BOARD_SIZE as usize * BOARD_SIZE as usize,
+    "rays.bin"
+);
+include_table!(
+    BISHOP_RAYS,
+    Bitboard,
+    BOARD_SIZE as usize * BOARD_SIZE as usize,
+    "bishop_rays.bin"
+);
+include_table!(
+    ROOK_RAYS,
+    Bitboard,
+    BOARD_SIZE as usize * BOARD_SIZE as usize,
+    "rook_rays.bin"
+);
 
-const KNIGHT_ATTACKS: [Bitboard; BOARD_SIZE as usize] = include!(concat!(
-    env!("CARGO_MANIFEST_DIR"),
-    "/generated/knight_attacks.rs"
-));
-const KING_ATTACKS: [Bitboard; BOARD_SIZE as usize] = include!(concat!(
-    env!("CARGO_MANIFEST_DIR"),
-    "/generated/king_attacks.rs"
-));
-const WHITE_PAWN_ATTACKS: [Bitboard; BOARD_SIZE as usize] = include!(concat!(
-    env!("CARGO_MANIFEST_DIR"),
-    "/generated/white_pawn_attacks.rs"
-));
-const BLACK_PAWN_ATTACKS: [Bitboard; BOARD_SIZE as usize] = include!(concat!(
-    env!("CARGO_MANIFEST_DIR"),
-    "/generated/black_pawn_attacks.rs"
-));
+include_table!(
+    KNIGHT_ATTACKS,
+    Bitboard,
+    BOARD_SIZE as usize,
+    "knight_attacks.bin"
+);
+include_table!(KING_ATTACKS, Bitboard, BOARD_SIZE as usize, "king_attacks.bin");
+include_table!(
+    WHITE_PAWN_ATTACKS,
+    Bitboard,
+    BOARD_SIZE as usize,
+    "white_pawn_attacks.bin"
+);
+include_table!(
+    BLACK_PAWN_ATTACKS,
+    Bitboard,
+    BOARD_SIZE as usize,
+    "black_pawn_attacks.bin"
+);
 
 // TODO: Abstract it out and support Fischer Random Chess.
 pub(super) const WHITE_SHORT_CASTLE_KING_WALK: Bitboard =
@@ -343,6 +622,46 @@ mod test {
         );
     }
 
+    #[test]
+    fn compact_tables_match_canonical() {
+        // The compacted (and, on non-BMI2 builds, magic-permuted) tables
+        // store the same data as the canonical PEXT-ordered ones: the lookups
+        // have to agree for any occupancy.
+        let mut state = 0xDEAD_BEEF_DEAD_BEEF_u64;
+        for _ in 0..1000 {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            let occupancy = Bitboard::from_bits(state.wrapping_mul(0x2545_F491_4F6C_DD1D));
+            for square in Square::iter() {
+                assert_eq!(
+                    rook_attacks(square, occupancy),
+                    ROOK_ATTACKS[ROOK_ATTACK_OFFSETS[square as usize]
+                        + pext(occupancy.bits(), ROOK_RELEVANT_OCCUPANCIES[square as usize])
+                            as usize]
+                );
+                assert_eq!(
+                    bishop_attacks(square, occupancy),
+                    BISHOP_ATTACKS[BISHOP_ATTACK_OFFSETS[square as usize]
+                        + pext(occupancy.bits(), BISHOP_RELEVANT_OCCUPANCIES[square as usize])
+                            as usize]
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn compact_tables_are_small() {
+        // Deduplication is the point of the layout: the distinct attack sets
+        // have to fit in the 16-bit indices with a lot of headroom, and the
+        // index table plus the unique sets should stay well under the raw
+        // 800 KiB of the rook table.
+        assert!(rook_table().unique.len() < 5000);
+        assert!(bishop_table().unique.len() < 1500);
+        assert_eq!(rook_table().indices.len(), ROOK_ATTACKS_COUNT);
+        assert_eq!(bishop_table().indices.len(), BISHOP_ATTACKS_COUNT);
+    }
+
     #[test]
     fn king() {
         assert_eq!(
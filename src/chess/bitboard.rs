@@ -38,7 +38,10 @@ use crate::chess::core::{
 /// bit corresponds to A1, and the most significant bit - to H8.
 ///
 /// Bitboard is a thin wrapper around [u64].
+// repr(transparent) makes the layout match u64 exactly: the pre-calculated
+// attack tables are loaded by casting from raw little-endian bytes.
 #[derive(Copy, Clone, PartialEq, Eq)]
+#[repr(transparent)]
 pub struct Bitboard {
     bits: u64,
 }
@@ -26,25 +26,70 @@ pub const BOARD_SIZE: u8 = BOARD_WIDTH * BOARD_WIDTH;
 /// also requires the [`crate::chess::position::Position`] it will be applied
 /// in, because SAN requires additional flags (e.g. indicating
 /// "check"/"checkmate" or moving piece disambiguation).
+///
+/// The move is packed into 16 bits ([From-To Based] encoding): 6 bits for
+/// each square and 4 for the promotion flags. Halving the footprint keeps a
+/// whole [`MoveList`] within a few cache lines, which matters when the search
+/// stack holds dozens of lists at once.
+///
+/// [From-To Based]: https://www.chessprogramming.org/Encoding_Moves#From-To_Based
 // TODO: Implement bijection for a move and a numeric index.
-// TODO: Switch this to an enum representation (regular, en passant, castling).
-#[derive(Copy, Clone, Debug)]
-pub struct Move {
-    pub(super) from: Square,
-    pub(super) to: Square,
-    pub(super) promotion: Option<Promotion>,
-}
+#[derive(Copy, Clone, PartialEq, Eq)]
+pub struct Move(u16);
 
 impl Move {
+    const SQUARE_MASK: u16 = 0b11_1111;
+
     #[must_use]
     pub const fn new(from: Square, to: Square, promotion: Option<Promotion>) -> Self {
-        Self {
-            from,
-            to,
-            promotion,
+        let flags = match promotion {
+            None => 0,
+            Some(Promotion::Queen) => 1,
+            Some(Promotion::Rook) => 2,
+            Some(Promotion::Bishop) => 3,
+            Some(Promotion::Knight) => 4,
+        };
+        Self(from as u16 | ((to as u16) << 6) | (flags << 12))
+    }
+
+    /// Returns the square the piece is moving from.
+    #[must_use]
+    pub const fn from_square(self) -> Square {
+        unsafe { mem::transmute((self.0 & Self::SQUARE_MASK) as u8) }
+    }
+
+    /// Returns the square the piece is moving to.
+    #[must_use]
+    pub const fn to_square(self) -> Square {
+        unsafe { mem::transmute(((self.0 >> 6) & Self::SQUARE_MASK) as u8) }
+    }
+
+    /// Returns the piece a pawn is promoted to, if the move is a promotion.
+    #[must_use]
+    pub const fn promotion(self) -> Option<Promotion> {
+        match self.0 >> 12 {
+            1 => Some(Promotion::Queen),
+            2 => Some(Promotion::Rook),
+            3 => Some(Promotion::Bishop),
+            4 => Some(Promotion::Knight),
+            _ => None,
         }
     }
 
+    /// Returns the raw 16-bit encoding, e.g. for compact storage in the
+    /// transposition table.
+    #[must_use]
+    pub const fn bits(self) -> u16 {
+        self.0
+    }
+
+    /// Reassembles a move from [`Move::bits`]. The squares are valid for any
+    /// input; unknown promotion flags are treated as "no promotion".
+    #[must_use]
+    pub const fn from_bits(bits: u16) -> Self {
+        Self(bits)
+    }
+
     #[must_use]
     pub fn from_san(_position: &Position) -> Self {
         todo!()
@@ -56,14 +101,20 @@ impl fmt::Display for Move {
     ///
     /// [UCI format]: http://wbec-ridderkerk.nl/html/UCIProtocol.html
     fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
-        write!(f, "{}{}", self.from, self.to)?;
-        if let Some(promotion) = self.promotion {
+        write!(f, "{}{}", self.from_square(), self.to_square())?;
+        if let Some(promotion) = self.promotion() {
             write!(f, "{}", PieceKind::from(promotion))?;
         }
         Ok(())
     }
 }
 
+impl fmt::Debug for Move {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        write!(f, "Move({self})")
+    }
+}
+
 /// Size of [`MoveList`] and an upper bound of moves in a chess position (which
 /// [seems to be 218](https://www.chessprogramming.org/Chess_Position). 256 provides the best
 /// performance through optimal memory alignment.
@@ -74,6 +125,34 @@ const MAX_MOVES: usize = 256;
 /// if the moves would be stored in `std::Vec` with unknown capacity.
 pub type MoveList = arrayvec::ArrayVec<Move, { MAX_MOVES }>;
 
+/// A [`Move`] co-located with its ordering score, so that selecting the next
+/// best move touches a single 4-byte slot.
+#[derive(Copy, Clone, Debug)]
+pub struct ScoredMove {
+    #[allow(missing_docs)]
+    pub next_move: Move,
+    #[allow(missing_docs)]
+    pub score: i16,
+}
+
+/// A move list variant carrying ordering scores, consumed through
+/// [`select_next_move`].
+pub type ScoredMoveList = arrayvec::ArrayVec<ScoredMove, { MAX_MOVES }>;
+
+/// Swaps the best-scoring move among `moves[start..]` into `moves[start]` and
+/// returns it: a single step of an in-place selection sort. Search typically
+/// consumes only the first few moves of a list before a cutoff, so selecting
+/// them lazily beats sorting the whole list upfront.
+pub fn select_next_move(moves: &mut [ScoredMove], start: usize) -> Option<Move> {
+    let (best, _) = moves
+        .iter()
+        .enumerate()
+        .skip(start)
+        .max_by_key(|(_, scored)| scored.score)?;
+    moves.swap(start, best);
+    Some(moves[start].next_move)
+}
+
 /// Board squares: from left to right, from bottom to the top ([Little-Endian Rank-File Mapping]):
 ///
 /// ```
@@ -830,6 +909,45 @@ mod test {
         assert_eq!(size_of_val(&square_to_pieces), BOARD_SIZE as usize);
     }
 
+    #[test]
+    fn move_packing() {
+        assert_eq!(size_of::<Move>(), 2);
+        for (next_move, expected) in [
+            (Move::new(Square::E2, Square::E4, None), "e2e4"),
+            (
+                Move::new(Square::E7, Square::E8, Some(Promotion::Queen)),
+                "e7e8q",
+            ),
+            (
+                Move::new(Square::B2, Square::A1, Some(Promotion::Knight)),
+                "b2a1n",
+            ),
+        ] {
+            assert_eq!(next_move.to_string(), expected);
+            assert_eq!(Move::from_bits(next_move.bits()), next_move);
+        }
+    }
+
+    #[test]
+    fn scored_move_selection() {
+        assert_eq!(size_of::<ScoredMove>(), 4);
+        let mut moves = ScoredMoveList::new();
+        for (from, to, score) in [
+            (Square::E2, Square::E4, 10),
+            (Square::D2, Square::D4, 30),
+            (Square::G1, Square::F3, 20),
+        ] {
+            moves.push(ScoredMove {
+                next_move: Move::new(from, to, None),
+                score,
+            });
+        }
+        assert_eq!(select_next_move(&mut moves, 0).unwrap().to_string(), "d2d4");
+        assert_eq!(select_next_move(&mut moves, 1).unwrap().to_string(), "g1f3");
+        assert_eq!(select_next_move(&mut moves, 2).unwrap().to_string(), "e2e4");
+        assert!(select_next_move(&mut moves, 3).is_none());
+    }
+
     #[test]
     fn square_shift() {
         assert_eq!(Square::A2.shift(Direction::Up), Some(Square::A3));
@@ -19,12 +19,51 @@ use crate::chess::core::{
     Move,
     MoveList,
     Piece,
+    PieceKind,
     Player,
     Promotion,
     Rank,
     Square,
     BOARD_WIDTH,
 };
+use crate::chess::zobrist;
+
+/// Stores the irreversible parts of [`Position`] state that
+/// [`Position::make_move`] overwrites, so that [`Position::unmake_move`] can
+/// restore them without snapshotting the whole board. This makes make/unmake
+/// cheap enough for tree traversal (e.g. [`perft`] and search) to walk the tree
+/// in-place instead of cloning [`Position`] for every node.
+#[derive(Clone)]
+struct UndoState {
+    next_move: Move,
+    captured: Option<PieceKind>,
+    castling: CastleRights,
+    en_passant_square: Option<Square>,
+    halfmove_clock: u8,
+    /// Zobrist key of the position before the move was made. Restoring it
+    /// makes unmake trivial and doubles as the hash history used for
+    /// repetition detection.
+    hash: u64,
+    checkers: Bitboard,
+}
+
+/// Verdict of [`Position::game_status`]: whether the game is over and why.
+/// The checkmated/stalemated side is the side to move.
+#[derive(Copy, Clone, Debug, Eq, PartialEq)]
+pub enum GameStatus {
+    /// The side to move has no legal moves and is in check.
+    Checkmate,
+    /// The side to move has no legal moves and is not in check.
+    Stalemate,
+    /// The position occurred for the third time.
+    DrawByRepetition,
+    /// Fifty full moves passed without a capture or a pawn move.
+    DrawByFiftyMoveRule,
+    /// Neither side can ever deliver checkmate.
+    DrawByInsufficientMaterial,
+    /// The game goes on.
+    Ongoing,
+}
 
 /// State of the chess game: board, half-move counters and castling rights,
 /// etc. It has 1:1 relationship with [Forsyth-Edwards Notation] (FEN).
@@ -43,7 +82,6 @@ use crate::chess::core::{
 /// [Extended Position Description]: https://www.chessprogramming.org/Extended_Position_Description
 /// [Operations]: https://www.chessprogramming.org/Extended_Position_Description#Operations
 // TODO: Make the fields private, expose appropriate assessors.
-// TODO: Store Zobrist hash, possibly other info.
 #[derive(Clone)]
 pub struct Position {
     board: Board,
@@ -61,6 +99,22 @@ pub struct Position {
     halfmove_clock: u8,
     fullmove_counter: u16,
     en_passant_square: Option<Square>,
+    /// Irreversible state for each move made so far, allowing
+    /// [`Position::unmake_move`] to rewind the position.
+    undo_stack: Vec<UndoState>,
+    /// [Zobrist key] of the position, maintained incrementally by
+    /// [`Position::make_move`].
+    ///
+    /// [Zobrist key]: https://www.chessprogramming.org/Zobrist_Hashing
+    hash: u64,
+    /// Opponent pieces giving check to the king of the side to move, cached
+    /// on each [`Position::make_move`] so that [`Position::in_check`] is free
+    /// for search to call at every node.
+    checkers: Bitboard,
+    /// Per-piece attack bitboards, repaired incrementally on each
+    /// [`Position::make_move`]/[`Position::unmake_move`] instead of being
+    /// rebuilt from zero for every move generation.
+    attack_map: attacks::AttackMap,
 }
 
 impl Position {
@@ -77,24 +131,134 @@ impl Position {
     /// ```
     #[must_use]
     pub fn starting() -> Self {
-        Self {
+        let mut result = Self {
             board: Board::starting(),
             castling: CastleRights::ALL,
             ..Self::empty()
-        }
+        };
+        result.hash = result.compute_hash();
+        result.checkers = result.compute_checkers();
+        result.attack_map = attacks::AttackMap::new(&result.board);
+        result
     }
 
     fn empty() -> Self {
         Self {
+            attack_map: attacks::AttackMap::new(&Board::empty()),
             board: Board::empty(),
             castling: CastleRights::NONE,
             side_to_move: Player::White,
             halfmove_clock: 0,
             fullmove_counter: 1,
             en_passant_square: None,
+            undo_stack: Vec::new(),
+            hash: 0,
+            checkers: Bitboard::empty(),
+        }
+    }
+
+    /// Returns the Zobrist key of the position. The key is maintained
+    /// incrementally by [`Position::make_move`] and [`Position::unmake_move`],
+    /// so reading it is free. Two positions that differ only in the move
+    /// counters have the same key.
+    #[must_use]
+    pub const fn hash(&self) -> u64 {
+        self.hash
+    }
+
+    /// Computes the Zobrist key of the position from scratch. Only used when a
+    /// position is constructed (e.g. parsed from FEN): afterwards the key is
+    /// maintained incrementally.
+    fn compute_hash(&self) -> u64 {
+        let mut hash = 0;
+        for player in [Player::White, Player::Black] {
+            let pieces = self.pieces(player);
+            for (bitboard, kind) in [
+                (pieces.king, PieceKind::King),
+                (pieces.queens, PieceKind::Queen),
+                (pieces.rooks, PieceKind::Rook),
+                (pieces.bishops, PieceKind::Bishop),
+                (pieces.knights, PieceKind::Knight),
+                (pieces.pawns, PieceKind::Pawn),
+            ] {
+                for square in bitboard.iter() {
+                    hash ^= zobrist::piece(player, kind, square);
+                }
+            }
+        }
+        hash ^= zobrist::castling(self.castling);
+        if let Some(square) = self.en_passant_square {
+            hash ^= zobrist::en_passant(square.file());
+        }
+        if self.side_to_move == Player::Black {
+            hash ^= zobrist::SIDE_TO_MOVE_KEY;
+        }
+        hash
+    }
+
+    /// Returns true if the current position occurred at least twice before in
+    /// the game, which is a draw by the [threefold repetition] rule.
+    ///
+    /// Positions are compared through their Zobrist keys recorded on each
+    /// make_move: only the moves since the last irreversible move (capture or
+    /// pawn push, tracked by the halfmove clock) have to be scanned.
+    ///
+    /// [threefold repetition]: https://www.chessprogramming.org/Repetitions
+    #[must_use]
+    pub fn is_threefold_repetition(&self) -> bool {
+        let lookback = (self.halfmove_clock as usize).min(self.undo_stack.len());
+        self.undo_stack
+            .iter()
+            .rev()
+            .take(lookback)
+            .filter(|undo| undo.hash == self.hash)
+            .count()
+            >= 2
+    }
+
+    /// Returns the player who makes the next move.
+    #[must_use]
+    pub const fn side_to_move(&self) -> Player {
+        self.side_to_move
+    }
+
+    /// Returns the number of halfmoves since the last capture or pawn move
+    /// (the FEN halfmove clock), which drives the fifty-move rule.
+    #[must_use]
+    pub const fn halfmove_clock(&self) -> u8 {
+        self.halfmove_clock
+    }
+
+    /// Returns the piece occupying `square`, if any. This is how evaluation
+    /// reads the board without access to its internals.
+    #[must_use]
+    pub fn at(&self, square: Square) -> Option<Piece> {
+        self.board.at(square)
+    }
+
+    /// Returns the bitboard of `player` pieces of the given kind, e.g. for
+    /// expanding the board into evaluation feature planes.
+    #[must_use]
+    pub fn occupied_by(&self, player: Player, kind: PieceKind) -> Bitboard {
+        let pieces = self.pieces(player);
+        match kind {
+            PieceKind::King => pieces.king,
+            PieceKind::Queen => pieces.queens,
+            PieceKind::Rook => pieces.rooks,
+            PieceKind::Bishop => pieces.bishops,
+            PieceKind::Knight => pieces.knights,
+            PieceKind::Pawn => pieces.pawns,
         }
     }
 
+    /// Returns the number of `player` pieces of the given kind. This is what
+    /// evaluation needs to compute material features without access to the
+    /// board internals.
+    #[must_use]
+    pub fn piece_count(&self, player: Player, kind: PieceKind) -> u32 {
+        self.occupied_by(player, kind).count()
+    }
+
     pub(super) fn us(&self) -> Player {
         self.side_to_move
     }
@@ -147,116 +311,141 @@ impl Position {
     /// extra symbols.
     // was not legal.
     pub fn from_fen(input: &str) -> anyhow::Result<Self> {
-        let mut parts = input.split(' ');
-        // Parse Piece Placement.
+        Self::from_ascii(input.as_bytes())
+    }
+
+    /// Parses a position from FEN or EPD given as raw ASCII bytes. This is
+    /// the bulk-loading workhorse behind [`Position::from_fen`]: it walks the
+    /// input byte by byte without allocating, so corpora with millions of
+    /// lines can be parsed straight out of a memory-mapped file (see
+    /// [`crate::util::Corpus`]) without materializing a `String` per line.
+    ///
+    /// # Errors
+    ///
+    /// Returns an error if the input is not a properly formatted FEN/EPD
+    /// position or fails the position validation heuristics.
+    pub fn from_ascii(input: &[u8]) -> anyhow::Result<Self> {
         let mut result = Self::empty();
-        let pieces_placement = match parts.next() {
-            Some(placement) => placement,
-            None => bail!("incorrect FEN: missing pieces placement"),
+        let mut pos = 0;
+        // Piece placement: ranks 8 down to 1, separated by '/'.
+        let (mut rank, mut file) = (BOARD_WIDTH - 1, 0);
+        loop {
+            match input.get(pos) {
+                Some(b' ') => {
+                    pos += 1;
+                    break;
+                },
+                Some(b'/') => {
+                    if file != BOARD_WIDTH {
+                        bail!("incorrect FEN: rank size should be exactly {BOARD_WIDTH}");
+                    }
+                    if rank == 0 {
+                        bail!("incorrect FEN: expected 8 ranks");
+                    }
+                    rank -= 1;
+                    file = 0;
+                    pos += 1;
+                },
+                Some(&increment @ b'1'..=b'8') => {
+                    file += increment - b'0';
+                    if file > BOARD_WIDTH {
+                        bail!("incorrect FEN: rank size should be exactly {BOARD_WIDTH}");
+                    }
+                    pos += 1;
+                },
+                Some(&symbol) if symbol.is_ascii_alphabetic() => {
+                    if file >= BOARD_WIDTH {
+                        bail!("incorrect FEN: rank size should be exactly {BOARD_WIDTH}");
+                    }
+                    let owner = if symbol.is_ascii_uppercase() {
+                        &mut result.board.white_pieces
+                    } else {
+                        &mut result.board.black_pieces
+                    };
+                    let bitboard = match symbol.to_ascii_lowercase() {
+                        b'k' => &mut owner.king,
+                        b'q' => &mut owner.queens,
+                        b'r' => &mut owner.rooks,
+                        b'b' => &mut owner.bishops,
+                        b'n' => &mut owner.knights,
+                        b'p' => &mut owner.pawns,
+                        _ => bail!("piece symbol should be in [PNBRQKpnbrqk], got {}", symbol as char),
+                    };
+                    *bitboard |= Bitboard::from(Square::new(file.try_into()?, rank.try_into()?));
+                    file += 1;
+                    pos += 1;
+                },
+                _ => bail!("incorrect FEN: incomplete piece placement"),
+            }
+        }
+        if rank != 0 || file != BOARD_WIDTH {
+            bail!("incorrect FEN: there should be 8 ranks of 8 squares");
+        }
+        // Side to move.
+        result.side_to_move = match input.get(pos) {
+            Some(b'w') => Player::White,
+            Some(b'b') => Player::Black,
+            _ => bail!("incorrect FEN: side to move should be 'w' or 'b'"),
         };
-        let ranks = pieces_placement.split('/');
-        let mut rank_id = 8;
-        for rank_fen in ranks {
-            if rank_id == 0 {
-                bail!("incorrect FEN: expected 8 ranks, got {pieces_placement}");
-            }
-            rank_id -= 1;
-            let rank = Rank::try_from(rank_id)?;
-            let mut file: u8 = 0;
-            for symbol in rank_fen.chars() {
-                if file > BOARD_WIDTH {
-                    bail!("file exceeded {BOARD_WIDTH}");
-                }
-                match symbol {
-                    '0' => bail!("increment can not be 0"),
-                    '1'..='9' => {
-                        file += symbol as u8 - b'0';
-                        continue;
-                    },
-                    _ => (),
-                }
-                match Piece::try_from(symbol) {
-                    Ok(piece) => {
-                        let owner = match piece.owner {
-                            Player::White => &mut result.board.white_pieces,
-                            Player::Black => &mut result.board.black_pieces,
-                        };
-                        let square = Square::new(file.try_into()?, rank);
-                        *owner.bitboard_for(piece.kind) |= Bitboard::from(square);
-                    },
-                    Err(e) => return Err(e),
-                }
-                file += 1;
+        pos += 1;
+        expect_separator(input, &mut pos)?;
+        // Castling rights.
+        if input.get(pos) == Some(&b'-') {
+            pos += 1;
+        } else {
+            while let Some(&symbol) = input.get(pos) {
+                result.castling |= match symbol {
+                    b'K' => CastleRights::WHITE_SHORT,
+                    b'Q' => CastleRights::WHITE_LONG,
+                    b'k' => CastleRights::BLACK_SHORT,
+                    b'q' => CastleRights::BLACK_LONG,
+                    b' ' => break,
+                    _ => bail!(
+                        "castling rights should be '-' or in [KQkq], got {}",
+                        symbol as char
+                    ),
+                };
+                pos += 1;
             }
-            if file != BOARD_WIDTH {
-                bail!("incorrect FEN: rank size should be exactly {BOARD_WIDTH}, got {rank_fen} of length {file}");
+        }
+        expect_separator(input, &mut pos)?;
+        // En passant square.
+        if input.get(pos) == Some(&b'-') {
+            pos += 1;
+        } else {
+            match (input.get(pos), input.get(pos + 1)) {
+                (Some(&file @ b'a'..=b'h'), Some(&rank @ b'1'..=b'8')) => {
+                    result.en_passant_square = Some(Square::new(
+                        File::try_from(file - b'a')?,
+                        Rank::try_from(rank - b'1')?,
+                    ));
+                    pos += 2;
+                },
+                _ => bail!("incorrect FEN: en passant square should be '-' or a square"),
             }
         }
-        if rank_id != 0 {
-            bail!("incorrect FEN: there should be 8 ranks, got {pieces_placement}");
+        // Halfmove clock and fullmove counter are optional: the EPD-style
+        // strings common in position books and datasets drop them.
+        if pos < input.len() {
+            expect_separator(input, &mut pos)?;
+            result.halfmove_clock = parse_counter(input, &mut pos)
+                .context("incorrect FEN: halfmove clock can not be parsed")?;
+            expect_separator(input, &mut pos)?;
+            result.fullmove_counter = parse_counter(input, &mut pos)
+                .context("incorrect FEN: fullmove counter can not be parsed")?;
+            if result.fullmove_counter == 0 {
+                bail!("fullmove counter can not be 0");
+            }
+            if pos != input.len() {
+                bail!("trailing symbols are not allowed in FEN");
+            }
         }
-        result.side_to_move = match parts.next() {
-            Some(value) => value.try_into()?,
-            None => bail!("incorrect FEN: missing side to move"),
-        };
-        result.castling = match parts.next() {
-            Some(value) => value.try_into()?,
-            None => bail!("incorrect FEN: missing castling rights"),
-        };
-        result.en_passant_square = match parts.next() {
-            Some("-") => None,
-            Some(value) => Some(value.try_into()?),
-            None => bail!("incorrect FEN: missing en passant square"),
-        };
-        result.halfmove_clock = match parts.next() {
-            Some(value) => {
-                // TODO: Here and below: parse manually just by getting through
-                // ASCII digits since we're already checking them.
-                if !value.bytes().all(|c| c.is_ascii_digit()) {
-                    bail!("halfmove clock can not contain anything other than digits");
-                }
-                match value.parse::<u8>() {
-                    Ok(num) => num,
-                    Err(e) => {
-                        return Err(e).with_context(|| {
-                            format!("incorrect FEN: halfmove clock can not be parsed {value}")
-                        });
-                    },
-                }
-            },
-            // This is a correct EPD: exit early.
-            None => {
-                return match validate(&result) {
-                    Ok(_) => Ok(result),
-                    Err(e) => Err(e.context("illegal position")),
-                }
-            },
-        };
-        result.fullmove_counter = match parts.next() {
-            Some(value) => {
-                if !value.bytes().all(|c| c.is_ascii_digit()) {
-                    bail!("fullmove counter clock can not contain anything other than digits");
-                }
-                match value.parse::<u16>() {
-                    Ok(0) => {
-                        bail!("fullmove counter can not be 0")
-                    },
-                    Ok(num) => num,
-                    Err(e) => {
-                        return Err(e).with_context(|| {
-                            format!("incorrect FEN: fullmove counter can not be parsed {value}")
-                        });
-                    },
-                }
-            },
-            None => bail!("incorrect FEN: missing halfmove clock"),
-        };
-        match parts.next() {
-            None => match validate(&result) {
-                Ok(_) => Ok(result),
-                Err(e) => Err(e.context("illegal position")),
-            },
-            Some(_) => bail!("trailing symbols are not allowed in FEN"),
+        result.hash = result.compute_hash();
+        result.checkers = result.compute_checkers();
+        result.attack_map = attacks::AttackMap::new(&result.board);
+        match validate(&result) {
+            Ok(_) => Ok(result),
+            Err(e) => Err(e.context("illegal position")),
         }
     }
 
@@ -266,9 +455,67 @@ impl Position {
         self.to_string()
     }
 
+    /// Checks whether neither player has enough material to ever deliver a
+    /// checkmate: king versus king, king and one minor piece versus king, or
+    /// any number of bishops that all stand on squares of one color. Such
+    /// games are drawn no matter what is played.
     #[must_use]
     pub fn has_insufficient_material(&self) -> bool {
-        todo!()
+        let (white, black) = (self.pieces(Player::White), self.pieces(Player::Black));
+        if (white.pawns | black.pawns | white.rooks | black.rooks | white.queens | black.queens)
+            .has_any()
+        {
+            return false;
+        }
+        let knights = white.knights | black.knights;
+        let bishops = white.bishops | black.bishops;
+        if knights.has_any() {
+            // A lone knight can never force mate; alongside any other minor
+            // piece mate becomes possible.
+            return knights.count() == 1 && bishops.is_empty();
+        }
+        // Bishops confined to one square color can never attack the other:
+        // no number of them mates, on either side.
+        const LIGHT_SQUARES: u64 = 0x55AA_55AA_55AA_55AA;
+        bishops.bits() & LIGHT_SQUARES == 0 || bishops.bits() & !LIGHT_SQUARES == 0
+    }
+
+    /// Classifies the position as ongoing or terminal in one pass. Playout
+    /// loops test for game end at every node, so this generates the move
+    /// list once and orders the remaining checks from cached scalar tests
+    /// (halfmove clock, checkers) to the bounded scans (hash history,
+    /// material bitboards). Callers that already hold the legal move list
+    /// should use [`Position::game_status_with_moves`] instead.
+    #[must_use]
+    pub fn game_status(&self) -> GameStatus {
+        self.game_status_with_moves(&self.generate_moves())
+    }
+
+    /// [`Position::game_status`] reusing an already-computed legal move list,
+    /// sparing the caller (e.g. search expansion, which generates the moves
+    /// anyway) a redundant generation pass. `legal_moves` must be exactly the
+    /// moves of this position.
+    #[must_use]
+    pub fn game_status_with_moves(&self, legal_moves: &[Move]) -> GameStatus {
+        if legal_moves.is_empty() {
+            return if self.in_check() {
+                GameStatus::Checkmate
+            } else {
+                GameStatus::Stalemate
+            };
+        }
+        // Checkmate on the board ends the game before any draw rule can be
+        // invoked, so the draw checks only run for positions with moves left.
+        if self.halfmove_clock >= 100 {
+            return GameStatus::DrawByFiftyMoveRule;
+        }
+        if self.is_threefold_repetition() {
+            return GameStatus::DrawByRepetition;
+        }
+        if self.has_insufficient_material() {
+            return GameStatus::DrawByInsufficientMaterial;
+        }
+        GameStatus::Ongoing
     }
 
     #[must_use]
@@ -282,7 +529,14 @@ impl Position {
         let king: Square = our_pieces.king.as_square();
         let (our_occupancy, their_occupancy) = (our_pieces.all(), their_pieces.all());
         let occupancy = our_occupancy | their_occupancy;
-        attacks::AttackInfo::new(they, their_pieces, king, our_occupancy, occupancy)
+        attacks::AttackInfo::new(
+            they,
+            their_pieces,
+            king,
+            our_occupancy,
+            occupancy,
+            &self.attack_map,
+        )
     }
 
     /// Calculates a list of legal moves (i.e. the moves that do not leave our
@@ -293,16 +547,14 @@ impl Position {
     ///
     /// NOTE: [BMI Instruction Set] (and specifically efficient [PEXT]) is not
     /// widely available on all processors (e.g. the AMD only started providing
-    /// an *efficient* PEXT since Ryzen 3). The current implementation will
-    /// rely on PEXT for performance because it is the most efficient move
-    /// generator technique available.
+    /// an *efficient* PEXT since Ryzen 3). The implementation relies on PEXT
+    /// for performance when the build targets BMI2 and falls back to Fancy
+    /// Magic Bitboards otherwise (see `chess::attacks`).
     ///
     /// [generation]: https://www.chessprogramming.org/Table-driven_Move_Generation
     /// [BMI2 Pext Bitboards]: https://www.chessprogramming.org/BMI2#PEXTBitboards
     /// [BMI Instruction Set]: https://en.wikipedia.org/wiki/X86_Bit_manipulation_instruction_set
     /// [PEXT]: https://en.wikipedia.org/wiki/X86_Bit_manipulation_instruction_set#Parallel_bit_deposit_and_extract
-    // TODO: Fall back to Fancy Magic Bitboards if BMI2 is not available for
-    // portability?
     // TODO: Look at and compare speed with https://github.com/jordanbray/chess
     // TODO: Another source for comparison:
     // https://github.com/sfleischman105/Pleco/blob/b825cecc258ad25cba65919208727994f38a06fb/pleco/src/board/movegen.rs#L68-L85
@@ -311,25 +563,96 @@ impl Position {
     // TODO: Compare with other engines and perft generators
     // (https://github.com/jniemann66/juddperft).
     // TODO: Check movegen comparison (https://github.com/Gigantua/Chess_Movegen).
-    // TODO: Use monomorphization to generate code for calculating attacks for both sides to reduce
-    // branching? https://rustc-dev-guide.rust-lang.org/backend/monomorph.html
     // TODO: Split into subroutines so that it's easier to tune performance.
     #[must_use]
     pub fn generate_moves(&self) -> MoveList {
+        crate::stats::record(crate::stats::Event::GenerateMoves, 1);
+        self.generate_staged_moves(true, true)
+    }
+
+    /// Calculates the legal captures (including en passant). This is the
+    /// first stage of [staged move generation]: search and playout policies
+    /// usually consume only a few good captures before a cutoff, so
+    /// generating the quiet moves upfront is wasted work. Promotions by a
+    /// pawn push land on an empty square and are generated by
+    /// [`Position::generate_quiets`].
+    ///
+    /// [staged move generation]: https://www.chessprogramming.org/Move_Generation#Staged_Move_Generation
+    #[must_use]
+    pub fn generate_captures(&self) -> MoveList {
+        crate::stats::record(crate::stats::Event::GenerateCaptures, 1);
+        self.generate_staged_moves(true, false)
+    }
+
+    /// Calculates the legal non-captures: the last stage of staged move
+    /// generation. Together with [`Position::generate_captures`] this yields
+    /// exactly the moves of [`Position::generate_moves`].
+    #[must_use]
+    pub fn generate_quiets(&self) -> MoveList {
+        self.generate_staged_moves(false, true)
+    }
+
+    /// Calculates the legal moves while the king is in check. Every legal
+    /// move resolves the check (the generator is already restricted to king
+    /// retreats, blocks and checker captures), so this is the complete move
+    /// list: staged consumers call it instead of running the capture and
+    /// quiet stages separately.
+    #[must_use]
+    pub fn generate_evasions(&self) -> MoveList {
+        debug_assert!(self.in_check());
+        self.generate_staged_moves(true, true)
+    }
+
+    fn generate_staged_moves(&self, captures: bool, quiets: bool) -> MoveList {
+        // Monomorphize the hot path over the side to move: the per-player
+        // branches (pawn push direction, backranks, attack table selection)
+        // are resolved at compile time in each instantiation instead of being
+        // data-dependent branches the predictor keeps missing.
+        match self.us() {
+            Player::White => self.generate_staged_moves_for::<true>(captures, quiets),
+            Player::Black => self.generate_staged_moves_for::<false>(captures, quiets),
+        }
+    }
+
+    fn generate_staged_moves_for<const IS_WHITE: bool>(
+        &self,
+        captures: bool,
+        quiets: bool,
+    ) -> MoveList {
         let mut moves = MoveList::new();
         // debug_assert!(validate(&self).is_ok(), "{}", self.fen());
         // TODO: Try caching more e.g. all()s? Benchmark to confirm that this is an
         // improvement.
-        let (us, they) = (self.us(), self.they());
+        let (us, they) = if IS_WHITE {
+            (Player::White, Player::Black)
+        } else {
+            (Player::Black, Player::White)
+        };
+        debug_assert_eq!(us, self.us());
         let (our_pieces, their_pieces) = (self.pieces(us), self.pieces(they));
         let king: Square = our_pieces.king.as_square();
         let (our_occupancy, their_occupancy) = (our_pieces.all(), their_pieces.all());
         let occupied_squares = our_occupancy | their_occupancy;
-        let their_or_empty = !our_occupancy;
-        let attack_info =
-            attacks::AttackInfo::new(they, their_pieces, king, our_occupancy, occupied_squares);
+        // Restricts the generated moves to the requested stages: capture
+        // targets are squares occupied by the opponent, quiet targets are
+        // empty squares.
+        let mut targets = Bitboard::empty();
+        if captures {
+            targets |= their_occupancy;
+        }
+        if quiets {
+            targets |= !occupied_squares;
+        }
+        let attack_info = attacks::AttackInfo::new(
+            they,
+            their_pieces,
+            king,
+            our_occupancy,
+            occupied_squares,
+            &self.attack_map,
+        );
         // Moving the king to safety is always a valid move.
-        generate_king_moves(king, attack_info.safe_king_squares, &mut moves);
+        generate_king_moves(king, attack_info.safe_king_squares & targets, &mut moves);
         // If there are checks, the moves are restricted to resolving them.
         let blocking_ray = match attack_info.checkers.count() {
             0 => Bitboard::full(),
@@ -359,7 +682,7 @@ impl Position {
         };
         generate_knight_moves(
             our_pieces.knights,
-            their_or_empty,
+            targets,
             attack_info.pins,
             blocking_ray,
             &mut moves,
@@ -367,7 +690,7 @@ impl Position {
         generate_rook_moves(
             our_pieces.rooks | our_pieces.queens,
             occupied_squares,
-            their_or_empty,
+            targets,
             blocking_ray,
             attack_info.pins,
             king,
@@ -376,38 +699,280 @@ impl Position {
         generate_bishop_moves(
             our_pieces.bishops | our_pieces.queens,
             occupied_squares,
-            their_or_empty,
+            targets,
             blocking_ray,
             attack_info.pins,
             king,
             &mut moves,
         );
-        generate_pawn_moves(
-            our_pieces.pawns,
-            us,
-            they,
-            their_pieces,
-            their_occupancy,
-            their_or_empty,
-            blocking_ray,
-            attack_info.pins,
-            attack_info.checkers,
-            king,
-            self.en_passant_square,
-            occupied_squares,
-            &mut moves,
-        );
-        generate_castle_moves(
-            us,
-            attack_info.checkers,
-            self.castling,
-            attack_info.attacks,
-            occupied_squares,
-            &mut moves,
-        );
+        if captures {
+            generate_pawn_captures::<IS_WHITE>(
+                our_pieces.pawns,
+                their_pieces,
+                their_occupancy,
+                blocking_ray,
+                attack_info.pins,
+                attack_info.checkers,
+                king,
+                self.en_passant_square,
+                occupied_squares,
+                &mut moves,
+            );
+        }
+        if quiets {
+            generate_pawn_pushes::<IS_WHITE>(
+                our_pieces.pawns,
+                blocking_ray,
+                attack_info.pins,
+                king,
+                occupied_squares,
+                &mut moves,
+            );
+            generate_castle_moves::<IS_WHITE>(
+                attack_info.checkers,
+                self.castling,
+                attack_info.attacks,
+                occupied_squares,
+                &mut moves,
+            );
+        }
         moves
     }
 
+    /// Returns true if the king of the side to move is under attack. The
+    /// checkers are cached by [`Position::make_move`], so this is a single
+    /// emptiness test: search can afford to call it at every node (e.g. for
+    /// check extensions or to switch to evasion generation).
+    #[must_use]
+    pub fn in_check(&self) -> bool {
+        self.checkers.has_any()
+    }
+
+    /// Computes the pieces giving check to the king of the side to move from
+    /// scratch: attacks are generated outwards from the king square and
+    /// intersected with the opponent pieces of the matching kind. Only used
+    /// when a position is constructed or mutated; reads go through the cached
+    /// [`Position::in_check`].
+    fn compute_checkers(&self) -> Bitboard {
+        if self.pieces(self.us()).king.count() != 1 {
+            // A board under construction (e.g. mid-FEN parsing) may have a
+            // missing or duplicated king; validation rejects such positions
+            // later.
+            return Bitboard::empty();
+        }
+        let (our_pieces, their_pieces) = (self.pieces(self.us()), self.pieces(self.they()));
+        let king: Square = our_pieces.king.as_square();
+        let occupancy = our_pieces.all() | their_pieces.all();
+        (attacks::knight_attacks(king) & their_pieces.knights)
+            | (attacks::pawn_attackers(king, self.they()) & their_pieces.pawns)
+            | (attacks::rook_attacks(king, occupancy)
+                & (their_pieces.rooks | their_pieces.queens))
+            | (attacks::bishop_attacks(king, occupancy)
+                & (their_pieces.bishops | their_pieces.queens))
+    }
+
+    /// Returns true if playing the given legal move would put the opponent
+    /// king in check. This answers the question without mutating the
+    /// position: move ordering and pruning heuristics want to know whether a
+    /// move checks long before (and more often than) the move is actually
+    /// made.
+    ///
+    /// Both direct checks (by the moved or promoted piece, including the rook
+    /// after castling) and discovered checks (sliders unblocked by the move,
+    /// including the en passant double-discovery) are detected by attack
+    /// probes on the occupancy the move would leave behind.
+    #[must_use]
+    pub fn gives_check(&self, next_move: &Move) -> bool {
+        let (from, to) = (next_move.from_square(), next_move.to_square());
+        let (us, they) = (self.us(), self.they());
+        let (our_pieces, their_pieces) = (self.pieces(us), self.pieces(they));
+        let their_king: Square = their_pieces.king.as_square();
+        let mut occupancy_after =
+            (our_pieces.all() | their_pieces.all()) - Bitboard::from(from) | Bitboard::from(to);
+        let is_pawn_move = our_pieces.pawns.contains(from);
+        if is_pawn_move && self.en_passant_square == Some(to) {
+            // The en passant victim vacates its square too, possibly opening
+            // a ray towards the opponent king.
+            occupancy_after -= Bitboard::from(Square::new(to.file(), from.rank()));
+        }
+        // Direct check by the piece arriving on the destination square.
+        let attacks_from_destination = if let Some(promotion) = next_move.promotion() {
+            match promotion {
+                Promotion::Queen => attacks::queen_attacks(to, occupancy_after),
+                Promotion::Rook => attacks::rook_attacks(to, occupancy_after),
+                Promotion::Bishop => attacks::bishop_attacks(to, occupancy_after),
+                Promotion::Knight => attacks::knight_attacks(to),
+            }
+        } else if is_pawn_move {
+            attacks::pawn_attacks(to, us)
+        } else if our_pieces.knights.contains(from) {
+            attacks::knight_attacks(to)
+        } else if our_pieces.queens.contains(from) {
+            attacks::queen_attacks(to, occupancy_after)
+        } else if our_pieces.rooks.contains(from) {
+            attacks::rook_attacks(to, occupancy_after)
+        } else if our_pieces.bishops.contains(from) {
+            attacks::bishop_attacks(to, occupancy_after)
+        } else {
+            // The king can never deliver a direct check, but castling moves
+            // the rook: probe from its post-castle square.
+            let our_backrank = Rank::backrank(us);
+            if from.rank() == our_backrank && from.file() == File::E {
+                let rook_squares = match to.file() {
+                    File::G => Some((File::H, File::F)),
+                    File::C => Some((File::A, File::D)),
+                    _ => None,
+                };
+                if let Some((rook_from, rook_to)) = rook_squares {
+                    let rook_to = Square::new(rook_to, our_backrank);
+                    occupancy_after -= Bitboard::from(Square::new(rook_from, our_backrank));
+                    occupancy_after |= Bitboard::from(rook_to);
+                    if attacks::rook_attacks(rook_to, occupancy_after).contains(their_king) {
+                        return true;
+                    }
+                }
+            }
+            Bitboard::empty()
+        };
+        if attacks_from_destination.contains(their_king) {
+            return true;
+        }
+        // Discovered check: a slider behind the vacated square(s) now sees
+        // the opponent king. The moved piece itself is excluded so that e.g.
+        // a rook sliding along the checking ray is not double-counted.
+        let moved = Bitboard::from(from);
+        (attacks::rook_attacks(their_king, occupancy_after)
+            & ((our_pieces.rooks | our_pieces.queens) - moved))
+            .has_any()
+            || (attacks::bishop_attacks(their_king, occupancy_after)
+                & ((our_pieces.bishops | our_pieces.queens) - moved))
+                .has_any()
+    }
+
+    /// Performs [Static Exchange Evaluation] of a move: the material balance
+    /// (in centipawns, from the perspective of the side to move) of the full
+    /// capture sequence on the destination square, assuming both sides keep
+    /// recapturing with their least valuable attacker and stop as soon as
+    /// standing pat is better. This resolves "is this capture winning or
+    /// losing material" with a handful of attack table lookups instead of a
+    /// make/generate/unmake cycle per ply of the exchange, which is what move
+    /// ordering needs: captures are sorted by SEE and losing ones are pruned
+    /// in quiescence.
+    ///
+    /// X-rays (a slider revealed behind a captured piece) are taken into
+    /// account by re-probing the slider tables on the shrinking occupancy.
+    /// Pins are not: like most SEE implementations, this treats every
+    /// recapture as legal, trading a little accuracy for speed.
+    ///
+    /// [Static Exchange Evaluation]: https://www.chessprogramming.org/Static_Exchange_Evaluation
+    #[must_use]
+    pub fn see(&self, next_move: &Move) -> i32 {
+        let (from, to) = (next_move.from_square(), next_move.to_square());
+        let (us, they) = (self.us(), self.they());
+        let (our_pieces, their_pieces) = (self.pieces(us), self.pieces(they));
+        let mut occupancy = (our_pieces.all() | their_pieces.all()) - Bitboard::from(from);
+        // Cumulative material balance after each capture in the sequence,
+        // from the perspective of the side that has just captured. The
+        // sequence can not be longer than the number of pieces on the board.
+        let mut gain = [0i32; 32];
+        let mut depth = 0;
+        gain[0] = match their_pieces.at(to) {
+            Some(kind) => exchange_value(kind),
+            None if our_pieces.pawns.contains(from) && self.en_passant_square == Some(to) => {
+                // En passant: the captured pawn is not on the destination
+                // square and its removal can reveal more attackers.
+                occupancy -= Bitboard::from(Square::new(to.file(), from.rank()));
+                exchange_value(PieceKind::Pawn)
+            },
+            // Quiet moves are allowed: the "exchange" is then just the
+            // opponent (possibly) winning the moved piece.
+            None => 0,
+        };
+        // Value of the piece currently standing on the destination square,
+        // i.e. what the next capture in the sequence would win.
+        let mut attacker_value = match our_pieces.at(from) {
+            Some(kind) => exchange_value(kind),
+            None => unreachable!("SEE probed a move with no piece on the source square"),
+        };
+        if let Some(promotion) = next_move.promotion() {
+            let promoted = exchange_value(PieceKind::from(promotion));
+            gain[0] += promoted - attacker_value;
+            attacker_value = promoted;
+        }
+        let diagonal_sliders =
+            our_pieces.bishops | our_pieces.queens | their_pieces.bishops | their_pieces.queens;
+        let straight_sliders =
+            our_pieces.rooks | our_pieces.queens | their_pieces.rooks | their_pieces.queens;
+        // All pieces of both sides attacking the destination square. Sliders
+        // are probed on the occupancy without the moving piece, so an x-ray
+        // behind it is already accounted for; `occupancy` masks out the
+        // pieces that have already been captured as the sequence unfolds.
+        let mut attackers = (attacks::knight_attacks(to)
+            & (our_pieces.knights | their_pieces.knights))
+            | (attacks::king_attacks(to) & (our_pieces.king | their_pieces.king))
+            | (attacks::rook_attacks(to, occupancy) & straight_sliders)
+            | (attacks::bishop_attacks(to, occupancy) & diagonal_sliders)
+            | (attacks::pawn_attackers(to, they) & their_pieces.pawns)
+            | (attacks::pawn_attackers(to, us) & our_pieces.pawns);
+        attackers &= occupancy;
+        let mut side = they;
+        loop {
+            let side_pieces = self.pieces(side);
+            let side_attackers = attackers & side_pieces.all();
+            if side_attackers.is_empty() {
+                break;
+            }
+            // Recapture with the least valuable attacker: it risks the least
+            // material if the exchange continues.
+            let (attacker_square, attacker_kind) = [
+                (side_pieces.pawns, PieceKind::Pawn),
+                (side_pieces.knights, PieceKind::Knight),
+                (side_pieces.bishops, PieceKind::Bishop),
+                (side_pieces.rooks, PieceKind::Rook),
+                (side_pieces.queens, PieceKind::Queen),
+                (side_pieces.king, PieceKind::King),
+            ]
+            .into_iter()
+            .find_map(|(bitboard, kind)| {
+                (side_attackers & bitboard)
+                    .iter()
+                    .next()
+                    .map(|square| (square, kind))
+            })
+            .expect("a non-empty attacker set has a least valuable piece");
+            if attacker_kind == PieceKind::King
+                && (attackers & self.pieces(side.opponent()).all()).has_any()
+            {
+                // The king can not recapture on a defended square.
+                break;
+            }
+            depth += 1;
+            gain[depth] = attacker_value - gain[depth - 1];
+            attacker_value = exchange_value(attacker_kind);
+            occupancy -= Bitboard::from(attacker_square);
+            attackers -= Bitboard::from(attacker_square);
+            // Removing the attacker can reveal a slider lined up behind it.
+            if matches!(
+                attacker_kind,
+                PieceKind::Pawn | PieceKind::Bishop | PieceKind::Queen
+            ) {
+                attackers |= attacks::bishop_attacks(to, occupancy) & diagonal_sliders;
+            }
+            if matches!(attacker_kind, PieceKind::Rook | PieceKind::Queen) {
+                attackers |= attacks::rook_attacks(to, occupancy) & straight_sliders;
+            }
+            attackers &= occupancy;
+            side = side.opponent();
+        }
+        // Negamax the speculative gains backwards: at each depth the side to
+        // move recaptures only when that beats standing pat.
+        while depth > 0 {
+            gain[depth - 1] = -std::cmp::max(-gain[depth - 1], gain[depth]);
+            depth -= 1;
+        }
+        gain[0]
+    }
+
     // TODO: Docs: this is the only way to mutate a position....
     // TODO: Make an checked version of it? With the move coming from the UCI
     // it's best to check if it's valid or not.
@@ -415,7 +980,47 @@ impl Position {
     // most usecases (e.g. for search) would clone the position and then mutate
     // it anyway. This would prevent (im)mutability reference problems.
     pub fn make_move(&mut self, next_move: &Move) {
+        let changed = self.changed_squares(next_move);
+        self.apply_move(next_move);
+        self.attack_map.repair(&self.board, changed);
+        self.checkers = self.compute_checkers();
+    }
+
+    /// Squares whose occupancy the move changes: source, destination and the
+    /// extra squares the en passant victim or the castling rook stand on.
+    /// This is the dirty set the incremental attack map has to repair; it
+    /// has to be computed while the move is not on the board (before
+    /// make_move or after unmake_move restores the state).
+    fn changed_squares(&self, next_move: &Move) -> Bitboard {
+        let (from, to) = (next_move.from_square(), next_move.to_square());
+        let mut changed = Bitboard::from(from) | Bitboard::from(to);
+        let our_pieces = self.pieces(self.us());
+        if our_pieces.pawns.contains(from) && self.en_passant_square == Some(to) {
+            changed |= Bitboard::from(Square::new(to.file(), from.rank()));
+        }
+        let our_backrank = Rank::backrank(self.us());
+        if our_pieces.king.contains(from)
+            && from == Square::new(File::E, our_backrank)
+            && to.rank() == our_backrank
+        {
+            if to.file() == File::G {
+                changed |= Bitboard::from(Square::new(File::H, our_backrank))
+                    | Bitboard::from(Square::new(File::F, our_backrank));
+            } else if to.file() == File::C {
+                changed |= Bitboard::from(Square::new(File::A, our_backrank))
+                    | Bitboard::from(Square::new(File::D, our_backrank));
+            }
+        }
+        changed
+    }
+
+    /// Applies the move to the board and the incrementally-maintained state.
+    /// Split from [`Position::make_move`] because the piece-type dispatch
+    /// below exits early, while the checkers cache has to be refreshed on
+    /// every path.
+    fn apply_move(&mut self, next_move: &Move) {
         // debug_assert!(self.is_legal());
+        let (from, to) = (next_move.from_square(), next_move.to_square());
         let (us, they) = (self.us(), self.they());
         let our_backrank = Rank::backrank(us);
         let (our_pieces, their_pieces) = match self.us() {
@@ -423,6 +1028,35 @@ impl Position {
             Player::Black => (&mut self.board.black_pieces, &mut self.board.white_pieces),
         };
         let previous_en_passant = self.en_passant_square;
+        // Record the irreversible state before it is overwritten so that
+        // unmake_move can restore it. The captured piece (if any) is the only
+        // board state that can not be recovered from the move itself.
+        let captured = if their_pieces.all().contains(to) {
+            their_pieces.at(to)
+        } else if our_pieces.pawns.contains(from)
+            && previous_en_passant == Some(to)
+        {
+            // En passant: the captured pawn is not on the destination square.
+            Some(PieceKind::Pawn)
+        } else {
+            None
+        };
+        self.undo_stack.push(UndoState {
+            next_move: *next_move,
+            captured,
+            castling: self.castling,
+            en_passant_square: previous_en_passant,
+            halfmove_clock: self.halfmove_clock,
+            hash: self.hash,
+            checkers: self.checkers,
+        });
+        // Update the hash for the state that changes unconditionally. The
+        // castling key is re-XORed at each place the rights can change and the
+        // piece keys are updated where the bitboards are modified.
+        self.hash ^= zobrist::SIDE_TO_MOVE_KEY;
+        if let Some(square) = previous_en_passant {
+            self.hash ^= zobrist::en_passant(square.file());
+        }
         self.en_passant_square = None;
         if us == Player::Black {
             self.fullmove_counter += 1;
@@ -432,101 +1066,235 @@ impl Position {
         // `us`.
         self.side_to_move = us.opponent();
         // Handle captures.
-        if our_pieces.rooks.contains(next_move.from) {
-            match (us, next_move.from) {
+        if our_pieces.rooks.contains(from) {
+            let castling_before = self.castling;
+            match (us, from) {
                 (Player::White, Square::A1) => self.castling.remove(CastleRights::WHITE_LONG),
                 (Player::White, Square::H1) => self.castling.remove(CastleRights::WHITE_SHORT),
                 (Player::Black, Square::A8) => self.castling.remove(CastleRights::BLACK_LONG),
                 (Player::Black, Square::H8) => self.castling.remove(CastleRights::BLACK_SHORT),
                 _ => (),
             }
+            // If the rights did not change, the two keys cancel out.
+            self.hash ^= zobrist::castling(castling_before) ^ zobrist::castling(self.castling);
         }
-        if their_pieces.all().contains(next_move.to) {
+        if their_pieces.all().contains(to) {
             // Capturing a piece resets the clock.
             self.halfmove_clock = 0;
-            match (they, next_move.to) {
+            let castling_before = self.castling;
+            match (they, to) {
                 (Player::White, Square::H1) => self.castling.remove(CastleRights::WHITE_SHORT),
                 (Player::White, Square::A1) => self.castling.remove(CastleRights::WHITE_LONG),
                 (Player::Black, Square::H8) => self.castling.remove(CastleRights::BLACK_SHORT),
                 (Player::Black, Square::A8) => self.castling.remove(CastleRights::BLACK_LONG),
                 _ => (),
             };
-            their_pieces.clear(next_move.to);
+            self.hash ^= zobrist::castling(castling_before) ^ zobrist::castling(self.castling);
+            if let Some(kind) = captured {
+                self.hash ^= zobrist::piece(they, kind, to);
+            }
+            their_pieces.clear(to);
         }
-        if our_pieces.pawns.contains(next_move.from) {
+        if our_pieces.pawns.contains(from) {
             // Pawn move resets the clock.
             self.halfmove_clock = 0;
             // Check en passant.
             if let Some(en_passant_square) = previous_en_passant {
-                if next_move.to == en_passant_square {
-                    let captured_pawn = Square::new(next_move.to.file(), next_move.from.rank());
+                if to == en_passant_square {
+                    let captured_pawn = Square::new(to.file(), from.rank());
                     their_pieces.pawns.clear(captured_pawn);
+                    self.hash ^= zobrist::piece(they, PieceKind::Pawn, captured_pawn);
                 }
             }
-            our_pieces.pawns.clear(next_move.from);
+            our_pieces.pawns.clear(from);
+            self.hash ^= zobrist::piece(us, PieceKind::Pawn, from);
             // Check promotions.
             // TODO: Debug assertions to make sure the promotion is valid.
-            if let Some(promotion) = next_move.promotion {
+            if let Some(promotion) = next_move.promotion() {
                 match promotion {
-                    Promotion::Queen => our_pieces.queens.extend(next_move.to),
-                    Promotion::Rook => our_pieces.rooks.extend(next_move.to),
-                    Promotion::Bishop => our_pieces.bishops.extend(next_move.to),
-                    Promotion::Knight => our_pieces.knights.extend(next_move.to),
+                    Promotion::Queen => our_pieces.queens.extend(to),
+                    Promotion::Rook => our_pieces.rooks.extend(to),
+                    Promotion::Bishop => our_pieces.bishops.extend(to),
+                    Promotion::Knight => our_pieces.knights.extend(to),
                 };
+                self.hash ^= zobrist::piece(us, PieceKind::from(promotion), to);
                 return;
             }
-            our_pieces.pawns.extend(next_move.to);
-            let single_push_square = next_move.from.shift(us.push_direction()).unwrap();
-            if next_move.from.rank() == Rank::pawns_starting(us)
-                && next_move.from.file() == next_move.to.file()
-                && single_push_square != next_move.to
+            our_pieces.pawns.extend(to);
+            self.hash ^= zobrist::piece(us, PieceKind::Pawn, to);
+            let single_push_square = from.shift(us.push_direction()).unwrap();
+            if from.rank() == Rank::pawns_starting(us)
+                && from.file() == to.file()
+                && single_push_square != to
                 // Technically, this is not correct: https://github.com/jhlywa/chess.js/issues/294
                 && (their_pieces.pawns & attacks::pawn_attacks(single_push_square, us)).has_any()
             {
                 self.en_passant_square = Some(single_push_square);
+                self.hash ^= zobrist::en_passant(single_push_square.file());
             }
             return;
         }
-        if our_pieces.king.contains(next_move.from) {
+        if our_pieces.king.contains(from) {
             // Check if the move is castling.
-            if next_move.from.rank() == our_backrank
-                && next_move.to.rank() == our_backrank
-                && next_move.from.file() == File::E
+            if from.rank() == our_backrank
+                && to.rank() == our_backrank
+                && from.file() == File::E
             {
-                if next_move.to.file() == File::G {
+                if to.file() == File::G {
                     // TODO: debug_assert!(self.can_castle_short())
                     our_pieces.rooks.clear(Square::new(File::H, our_backrank));
                     our_pieces.rooks.extend(Square::new(File::F, our_backrank));
-                } else if next_move.to.file() == File::C {
+                    self.hash ^=
+                        zobrist::piece(us, PieceKind::Rook, Square::new(File::H, our_backrank))
+                            ^ zobrist::piece(
+                                us,
+                                PieceKind::Rook,
+                                Square::new(File::F, our_backrank),
+                            );
+                } else if to.file() == File::C {
                     // TODO: debug_assert!(self.can_castle_long())
                     our_pieces.rooks.clear(Square::new(File::A, our_backrank));
                     our_pieces.rooks.extend(Square::new(File::D, our_backrank));
+                    self.hash ^=
+                        zobrist::piece(us, PieceKind::Rook, Square::new(File::A, our_backrank))
+                            ^ zobrist::piece(
+                                us,
+                                PieceKind::Rook,
+                                Square::new(File::D, our_backrank),
+                            );
                 }
             }
-            our_pieces.king.clear(next_move.from);
-            our_pieces.king.extend(next_move.to);
+            our_pieces.king.clear(from);
+            our_pieces.king.extend(to);
+            self.hash ^= zobrist::piece(us, PieceKind::King, from)
+                ^ zobrist::piece(us, PieceKind::King, to);
             // The king has moved: reset castling.
+            let castling_before = self.castling;
             match us {
                 Player::White => self.castling.remove(CastleRights::WHITE_BOTH),
                 Player::Black => self.castling.remove(CastleRights::BLACK_BOTH),
             };
+            self.hash ^= zobrist::castling(castling_before) ^ zobrist::castling(self.castling);
             return;
         }
         // Regular moves: put the piece from the source to destination. We
         // already cleared the opponent piece if there was a capture.
-        for piece in [
-            &mut our_pieces.queens,
-            &mut our_pieces.rooks,
-            &mut our_pieces.bishops,
-            &mut our_pieces.knights,
+        for (piece, kind) in [
+            (&mut our_pieces.queens, PieceKind::Queen),
+            (&mut our_pieces.rooks, PieceKind::Rook),
+            (&mut our_pieces.bishops, PieceKind::Bishop),
+            (&mut our_pieces.knights, PieceKind::Knight),
         ] {
-            if piece.contains(next_move.from) {
-                piece.clear(next_move.from);
-                piece.extend(next_move.to);
+            if piece.contains(from) {
+                piece.clear(from);
+                piece.extend(to);
+                self.hash ^= zobrist::piece(us, kind, from)
+                    ^ zobrist::piece(us, kind, to);
                 return;
             }
         }
     }
+
+    /// Reverts the last move made by [`Position::make_move`], restoring the
+    /// board and the irreversible state (castling rights, en passant square,
+    /// halfmove clock) from the undo stack.
+    ///
+    /// Together with [`Position::make_move`] this allows tree traversal to
+    /// mutate a single [`Position`] in-place instead of cloning it for every
+    /// node, which avoids copying both piece sets in the hottest loop.
+    ///
+    /// # Panics
+    ///
+    /// Panics if there is no move to unmake.
+    pub fn unmake_move(&mut self) {
+        let undo = self
+            .undo_stack
+            .pop()
+            .expect("unmake_move should only be called after make_move");
+        let next_move = undo.next_move;
+        let (from, to) = (next_move.from_square(), next_move.to_square());
+        self.hash = undo.hash;
+        self.checkers = undo.checkers;
+        // make_move flipped the side to move: flip it back to the mover.
+        self.side_to_move = self.side_to_move.opponent();
+        let us = self.side_to_move;
+        if us == Player::Black {
+            self.fullmove_counter -= 1;
+        }
+        self.halfmove_clock = undo.halfmove_clock;
+        self.castling = undo.castling;
+        self.en_passant_square = undo.en_passant_square;
+        let (our_pieces, their_pieces) = match us {
+            Player::White => (&mut self.board.white_pieces, &mut self.board.black_pieces),
+            Player::Black => (&mut self.board.black_pieces, &mut self.board.white_pieces),
+        };
+        // Move the piece back. Promotions dissolve back into a pawn.
+        if let Some(promotion) = next_move.promotion() {
+            match promotion {
+                Promotion::Queen => our_pieces.queens.clear(to),
+                Promotion::Rook => our_pieces.rooks.clear(to),
+                Promotion::Bishop => our_pieces.bishops.clear(to),
+                Promotion::Knight => our_pieces.knights.clear(to),
+            };
+            our_pieces.pawns.extend(from);
+        } else {
+            for piece in [
+                &mut our_pieces.king,
+                &mut our_pieces.queens,
+                &mut our_pieces.rooks,
+                &mut our_pieces.bishops,
+                &mut our_pieces.knights,
+                &mut our_pieces.pawns,
+            ] {
+                if piece.contains(to) {
+                    piece.clear(to);
+                    piece.extend(from);
+                    break;
+                }
+            }
+        }
+        // If the king castled, the rook has to be moved back, too. Mirrors the
+        // castle detection in make_move.
+        let our_backrank = Rank::backrank(us);
+        if our_pieces.king.contains(from)
+            && from.rank() == our_backrank
+            && to.rank() == our_backrank
+            && from.file() == File::E
+        {
+            if to.file() == File::G {
+                our_pieces.rooks.clear(Square::new(File::F, our_backrank));
+                our_pieces.rooks.extend(Square::new(File::H, our_backrank));
+            } else if to.file() == File::C {
+                our_pieces.rooks.clear(Square::new(File::D, our_backrank));
+                our_pieces.rooks.extend(Square::new(File::A, our_backrank));
+            }
+        }
+        // Restore the captured piece. For en passant captures the pawn is
+        // restored behind the destination square.
+        if let Some(captured) = undo.captured {
+            let captured_square = if captured == PieceKind::Pawn
+                && our_pieces.pawns.contains(from)
+                && undo.en_passant_square == Some(to)
+            {
+                Square::new(to.file(), from.rank())
+            } else {
+                to
+            };
+            their_pieces.bitboard_for(captured).extend(captured_square);
+        }
+        // The board is back to the pre-move state: the dirty set of the
+        // unmade move repairs the attack map just like in make_move.
+        let changed = self.changed_squares(&next_move);
+        self.attack_map.repair(&self.board, changed);
+    }
+
+    /// Returns all squares attacked by the given player's pieces. The data
+    /// comes from the incrementally maintained attack map, so this is cheap
+    /// enough for evaluation features (e.g. mobility) to read at every node.
+    #[must_use]
+    pub fn attacks_by(&self, player: Player) -> Bitboard {
+        self.attack_map.attacks_by(self.occupancy(player))
+    }
 }
 
 impl TryFrom<&str> for Position {
@@ -583,18 +1351,122 @@ impl fmt::Debug for Position {
 #[must_use]
 pub fn perft(position: &Position, depth: u8) -> u64 {
     debug_assert!(position.is_legal());
+    // Traverse the tree through make/unmake on a single copy instead of
+    // cloning the position for every node.
+    let mut position = position.clone();
+    perft_walk(&mut position, depth)
+}
+
+fn perft_walk(position: &mut Position, depth: u8) -> u64 {
     if depth == 0 {
         return 1;
     }
+    let moves = position.generate_moves();
+    // Bulk counting: there is no need to make the moves at the frontier, the
+    // number of legal moves is the number of leaves.
+    if depth == 1 {
+        return moves.len() as u64;
+    }
     let mut nodes = 0;
-    for next_move in position.generate_moves().iter() {
-        let mut next_position = position.clone();
-        next_position.make_move(next_move);
-        nodes += perft(&next_position, depth - 1);
+    for next_move in moves.iter() {
+        position.make_move(next_move);
+        nodes += perft_walk(position, depth - 1);
+        position.unmake_move();
     }
     nodes
 }
 
+/// Multi-threaded version of [`perft`]: the root moves are distributed
+/// between `threads` workers, each searching its subtree on a thread-local
+/// copy of the position. The workers dynamically pull the next unexplored
+/// root move from a shared queue, so unbalanced subtrees do not leave cores
+/// idle.
+#[must_use]
+pub fn perft_parallel(position: &Position, depth: u8, threads: usize) -> u64 {
+    debug_assert!(position.is_legal());
+    if depth == 0 {
+        return 1;
+    }
+    let moves = position.generate_moves();
+    if depth == 1 {
+        return moves.len() as u64;
+    }
+    let threads = threads.clamp(1, moves.len().max(1));
+    let next_root_move = std::sync::atomic::AtomicUsize::new(0);
+    std::thread::scope(|scope| {
+        let mut workers = Vec::with_capacity(threads);
+        for _ in 0..threads {
+            workers.push(scope.spawn(|| {
+                let mut position = position.clone();
+                let mut nodes = 0;
+                loop {
+                    let index =
+                        next_root_move.fetch_add(1, std::sync::atomic::Ordering::Relaxed);
+                    let next_move = match moves.get(index) {
+                        Some(next_move) => next_move,
+                        None => break,
+                    };
+                    position.make_move(next_move);
+                    nodes += perft_walk(&mut position, depth - 1);
+                    position.unmake_move();
+                }
+                nodes
+            }));
+        }
+        workers
+            .into_iter()
+            .map(|worker| worker.join().expect("perft worker should not panic"))
+            .sum()
+    })
+}
+
+// Consumes a single space separator at the cursor or fails.
+fn expect_separator(input: &[u8], pos: &mut usize) -> anyhow::Result<()> {
+    match input.get(*pos) {
+        Some(b' ') => {
+            *pos += 1;
+            Ok(())
+        },
+        _ => bail!("incorrect FEN: expected a space separator"),
+    }
+}
+
+// Parses an unsigned decimal counter (halfmove clock or fullmove counter) at
+// the cursor without going through UTF-8 machinery.
+fn parse_counter<T: TryFrom<u32>>(input: &[u8], pos: &mut usize) -> anyhow::Result<T> {
+    let mut value: u32 = 0;
+    let mut digits = 0;
+    while let Some(&symbol @ b'0'..=b'9') = input.get(*pos) {
+        value = value * 10 + u32::from(symbol - b'0');
+        digits += 1;
+        if digits > 6 {
+            bail!("counter has too many digits");
+        }
+        *pos += 1;
+    }
+    if digits == 0 {
+        bail!("counter can not contain anything other than digits");
+    }
+    match T::try_from(value) {
+        Ok(value) => Ok(value),
+        Err(_) => bail!("counter value {value} is out of range"),
+    }
+}
+
+// Piece values used by [`Position::see`], in centipawns. These are
+// deliberately coarse: exchange evaluation only needs a consistent ordering
+// of the piece kinds, not a tuned evaluation. The king value is large enough
+// that "winning" it dominates any material swing.
+const fn exchange_value(kind: PieceKind) -> i32 {
+    match kind {
+        PieceKind::Pawn => 100,
+        PieceKind::Knight | PieceKind::Bishop => 300,
+        PieceKind::Rook => 500,
+        PieceKind::Queen => 900,
+        PieceKind::King => 10_000,
+    }
+}
+
 // Checks if the position is "legal", i.e. if it can be reasoned about by
 // the engine. Checking whether the position is truly reachable from the
 // starting position (either in standard chess or Fischer Random Chess)
@@ -714,7 +1586,7 @@ fn generate_king_moves(king: Square, safe_squares: Bitboard, moves: &mut MoveLis
 
 fn generate_knight_moves(
     knights: Bitboard,
-    their_or_empty: Bitboard,
+    allowed_targets: Bitboard,
     pins: Bitboard,
     blocking_ray: Bitboard,
     moves: &mut MoveList,
@@ -722,7 +1594,7 @@ fn generate_knight_moves(
     // When a knight is pinned, it can not move at all because it can't stay on
     // the same horizontal, vertical or diagonal.
     for from in (knights - pins).iter() {
-        let targets = attacks::knight_attacks(from) & their_or_empty & blocking_ray;
+        let targets = attacks::knight_attacks(from) & allowed_targets & blocking_ray;
         for to in targets.iter() {
             unsafe {
                 moves.push_unchecked(Move::new(from, to, None));
@@ -734,14 +1606,15 @@ fn generate_knight_moves(
 fn generate_rook_moves(
     rooks: Bitboard,
     occupied_squares: Bitboard,
-    their_or_empty: Bitboard,
+    allowed_targets: Bitboard,
     blocking_ray: Bitboard,
     pins: Bitboard,
     king: Square,
     moves: &mut MoveList,
 ) {
     for from in rooks.iter() {
-        let targets = attacks::rook_attacks(from, occupied_squares) & their_or_empty & blocking_ray;
+        let targets =
+            attacks::rook_attacks(from, occupied_squares) & allowed_targets & blocking_ray;
         for to in targets.iter() {
             // TODO: This block is repeated several times; abstract it out.
             if pins.contains(from) && (attacks::ray(from, king) & attacks::ray(to, king)).is_empty()
@@ -756,7 +1629,7 @@ fn generate_rook_moves(
 fn generate_bishop_moves(
     bishops: Bitboard,
     occupied_squares: Bitboard,
-    their_or_empty: Bitboard,
+    allowed_targets: Bitboard,
     blocking_ray: Bitboard,
     pins: Bitboard,
     king: Square,
@@ -764,7 +1637,7 @@ fn generate_bishop_moves(
 ) {
     for from in bishops.iter() {
         let targets =
-            attacks::bishop_attacks(from, occupied_squares) & their_or_empty & blocking_ray;
+            attacks::bishop_attacks(from, occupied_squares) & allowed_targets & blocking_ray;
         for to in targets.iter() {
             // TODO: This block is repeated several times; abstract it out.
             if pins.contains(from) && (attacks::ray(from, king) & attacks::ray(to, king)).is_empty()
@@ -776,13 +1649,10 @@ fn generate_bishop_moves(
     }
 }
 
-fn generate_pawn_moves(
+fn generate_pawn_captures<const IS_WHITE: bool>(
     pawns: Bitboard,
-    us: Player,
-    they: Player,
     their_pieces: &Pieces,
     their_occupancy: Bitboard,
-    their_or_empty: Bitboard,
     blocking_ray: Bitboard,
     pins: Bitboard,
     checkers: Bitboard,
@@ -791,11 +1661,15 @@ fn generate_pawn_moves(
     occupied_squares: Bitboard,
     moves: &mut MoveList,
 ) {
+    let (us, they) = if IS_WHITE {
+        (Player::White, Player::Black)
+    } else {
+        (Player::Black, Player::White)
+    };
     // TODO: Get rid of the branch: AND pawns getting to the promotion rank and the
     // rest.
     for from in pawns.iter() {
-        let targets =
-            (attacks::pawn_attacks(from, us) & their_occupancy) & their_or_empty & blocking_ray;
+        let targets = attacks::pawn_attacks(from, us) & their_occupancy & blocking_ray;
         for to in targets.iter() {
             // TODO: This block is repeated several times; abstract it out.
             if pins.contains(from) && (attacks::ray(from, king) & attacks::ray(to, king)).is_empty()
@@ -849,6 +1723,21 @@ fn generate_pawn_moves(
             }
         }
     }
+}
+
+fn generate_pawn_pushes<const IS_WHITE: bool>(
+    pawns: Bitboard,
+    blocking_ray: Bitboard,
+    pins: Bitboard,
+    king: Square,
+    occupied_squares: Bitboard,
+    moves: &mut MoveList,
+) {
+    let us = if IS_WHITE {
+        Player::White
+    } else {
+        Player::Black
+    };
     // Regular pawn pushes.
     let push_direction = us.push_direction();
     let pawn_pushes = pawns.shift(push_direction) - occupied_squares;
@@ -896,8 +1785,7 @@ fn generate_pawn_moves(
     }
 }
 
-fn generate_castle_moves(
-    us: Player,
+fn generate_castle_moves<const IS_WHITE: bool>(
     checkers: Bitboard,
     castling: CastleRights,
     attacks: Bitboard,
@@ -907,55 +1795,52 @@ fn generate_castle_moves(
     // TODO: Generalize castling to FCR.
     // TODO: In FCR we should check if the rook is pinned or not.
     if checkers.is_empty() {
-        match us {
-            Player::White => {
-                if castling.contains(CastleRights::WHITE_SHORT)
+        if IS_WHITE {
+            if castling.contains(CastleRights::WHITE_SHORT)
                     && (attacks & attacks::WHITE_SHORT_CASTLE_KING_WALK).is_empty()
-                    && (occupied_squares
-                        & (attacks::WHITE_SHORT_CASTLE_KING_WALK
-                            | attacks::WHITE_SHORT_CASTLE_ROOK_WALK))
-                        .is_empty()
-                {
-                    unsafe {
-                        moves.push_unchecked(Move::new(Square::E1, Square::G1, None));
-                    }
+                && (occupied_squares
+                    & (attacks::WHITE_SHORT_CASTLE_KING_WALK
+                        | attacks::WHITE_SHORT_CASTLE_ROOK_WALK))
+                    .is_empty()
+            {
+                unsafe {
+                    moves.push_unchecked(Move::new(Square::E1, Square::G1, None));
                 }
-                if castling.contains(CastleRights::WHITE_LONG)
-                    && (attacks & attacks::WHITE_LONG_CASTLE_KING_WALK).is_empty()
-                    && (occupied_squares
-                        & (attacks::WHITE_LONG_CASTLE_KING_WALK
-                            | attacks::WHITE_LONG_CASTLE_ROOK_WALK))
-                        .is_empty()
-                {
-                    unsafe {
-                        moves.push_unchecked(Move::new(Square::E1, Square::C1, None));
-                    }
+            }
+            if castling.contains(CastleRights::WHITE_LONG)
+                && (attacks & attacks::WHITE_LONG_CASTLE_KING_WALK).is_empty()
+                && (occupied_squares
+                    & (attacks::WHITE_LONG_CASTLE_KING_WALK
+                        | attacks::WHITE_LONG_CASTLE_ROOK_WALK))
+                    .is_empty()
+            {
+                unsafe {
+                    moves.push_unchecked(Move::new(Square::E1, Square::C1, None));
                 }
-            },
-            Player::Black => {
-                if castling.contains(CastleRights::BLACK_SHORT)
-                    && (attacks & attacks::BLACK_SHORT_CASTLE_KING_WALK).is_empty()
-                    && (occupied_squares
-                        & (attacks::BLACK_SHORT_CASTLE_KING_WALK
-                            | attacks::BLACK_SHORT_CASTLE_ROOK_WALK))
-                        .is_empty()
-                {
-                    unsafe {
-                        moves.push_unchecked(Move::new(Square::E8, Square::G8, None));
-                    }
+            }
+        } else {
+            if castling.contains(CastleRights::BLACK_SHORT)
+                && (attacks & attacks::BLACK_SHORT_CASTLE_KING_WALK).is_empty()
+                && (occupied_squares
+                    & (attacks::BLACK_SHORT_CASTLE_KING_WALK
+                        | attacks::BLACK_SHORT_CASTLE_ROOK_WALK))
+                    .is_empty()
+            {
+                unsafe {
+                    moves.push_unchecked(Move::new(Square::E8, Square::G8, None));
                 }
-                if castling.contains(CastleRights::BLACK_LONG)
-                    && (attacks & attacks::BLACK_LONG_CASTLE_KING_WALK).is_empty()
-                    && (occupied_squares
-                        & (attacks::BLACK_LONG_CASTLE_KING_WALK
-                            | attacks::BLACK_LONG_CASTLE_ROOK_WALK))
-                        .is_empty()
-                {
-                    unsafe {
-                        moves.push_unchecked(Move::new(Square::E8, Square::C8, None));
-                    }
+            }
+            if castling.contains(CastleRights::BLACK_LONG)
+                && (attacks & attacks::BLACK_LONG_CASTLE_KING_WALK).is_empty()
+                && (occupied_squares
+                    & (attacks::BLACK_LONG_CASTLE_KING_WALK
+                        | attacks::BLACK_LONG_CASTLE_ROOK_WALK))
+                    .is_empty()
+            {
+                unsafe {
+                    moves.push_unchecked(Move::new(Square::E8, Square::C8, None));
                 }
-            },
+            }
         }
     }
 }
@@ -0,0 +1,75 @@
+//! [Zobrist hashing] provides a 64-bit signature of a chess position. The key
+//! is maintained incrementally in [`crate::chess::position::Position`] by
+//! XORing the affected keys in and out as moves are made and unmade, which
+//! makes hashing essentially free on the move making hot path. The signatures
+//! are the backbone of transposition tables and repetition detection.
+//!
+//! The keys are pseudo-random but have to be deterministic, so they are
+//! generated at compile time from fixed seeds using [SplitMix64].
+//!
+//! [Zobrist hashing]: https://www.chessprogramming.org/Zobrist_Hashing
+//! [SplitMix64]: https://prng.di.unimi.it/splitmix64.c
+
+use crate::chess::core::{CastleRights, File, PieceKind, Player, Square, BOARD_SIZE};
+
+/// One key for each (player, piece kind, square) combination.
+const PIECE_KEYS: [u64; 2 * 6 * BOARD_SIZE as usize] = generate_keys(0x9E37_79B9_7F4A_7C15);
+/// One key for each subset of castling rights ([`CastleRights`] bits).
+const CASTLING_KEYS: [u64; 16] = generate_keys(0xBF58_476D_1CE4_E5B9);
+/// One key for each possible en passant file.
+const EN_PASSANT_KEYS: [u64; 8] = generate_keys(0x94D0_49BB_1331_11EB);
+/// XORed in whenever it is Black to move.
+pub(super) const SIDE_TO_MOVE_KEY: u64 = 0xD6E8_FEB8_6659_FD93;
+
+/// Fills an array with pseudo-random keys produced by SplitMix64.
+const fn generate_keys<const N: usize>(seed: u64) -> [u64; N] {
+    let mut keys = [0; N];
+    let mut state = seed;
+    let mut index = 0;
+    while index < N {
+        state = state.wrapping_add(0x9E37_79B9_7F4A_7C15);
+        let mut key = state;
+        key = (key ^ (key >> 30)).wrapping_mul(0xBF58_476D_1CE4_E5B9);
+        key = (key ^ (key >> 27)).wrapping_mul(0x94D0_49BB_1331_11EB);
+        keys[index] = key ^ (key >> 31);
+        index += 1;
+    }
+    keys
+}
+
+pub(super) fn piece(player: Player, kind: PieceKind, square: Square) -> u64 {
+    let player_offset = match player {
+        Player::White => 0,
+        Player::Black => 6 * BOARD_SIZE as usize,
+    };
+    // PieceKind discriminants start at 1.
+    let kind_offset = (kind as usize - 1) * BOARD_SIZE as usize;
+    PIECE_KEYS[player_offset + kind_offset + square as usize]
+}
+
+pub(super) fn castling(rights: CastleRights) -> u64 {
+    CASTLING_KEYS[rights.bits() as usize]
+}
+
+pub(super) fn en_passant(file: File) -> u64 {
+    EN_PASSANT_KEYS[file as usize]
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn keys_are_unique() {
+        let mut keys: Vec<u64> = PIECE_KEYS
+            .iter()
+            .chain(CASTLING_KEYS.iter())
+            .chain(EN_PASSANT_KEYS.iter())
+            .copied()
+            .chain(std::iter::once(SIDE_TO_MOVE_KEY))
+            .collect();
+        keys.sort_unstable();
+        keys.dedup();
+        assert_eq!(keys.len(), 2 * 6 * 64 + 16 + 8 + 1);
+    }
+}
@@ -1 +1,8 @@
+//! Static evaluation of a single position: tells the search how good a
+//! position is without looking at any continuations.
+
+pub mod batch;
+pub mod cache;
 pub mod evaluator;
+pub mod nnue;
+pub mod simd;
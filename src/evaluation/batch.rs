@@ -0,0 +1,164 @@
+//! Batched evaluation service: neural network inference is an order of
+//! magnitude more efficient on a batch of positions than one at a time, but
+//! MCTS produces evaluation requests one leaf per simulation. The service
+//! decouples the two: search threads submit positions and park on a
+//! [`Pending`] handle, a dedicated service thread coalesces everything
+//! queued up (up to the batch limit) into one batched forward pass and wakes
+//! the submitters with their results. The more search threads are in
+//! flight, the fuller the batches get — exactly the load shape the planned
+//! deployment has.
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, Condvar, Mutex};
+
+use crate::chess::position::Position;
+
+/// Evaluator of a whole batch of unrelated positions, in centipawns from the
+/// side to move perspective, one score per input position. This is the
+/// extension point for SIMD/GPU backends: the service itself is agnostic to
+/// how the batch is crunched.
+pub trait BatchEvaluator: Send {
+    #[allow(missing_docs)]
+    fn evaluate_batch(&mut self, positions: &[Position]) -> Vec<i32>;
+}
+
+/// One queued request: the position to evaluate and the slot the submitter
+/// is parked on.
+struct Request {
+    position: Position,
+    slot: Arc<Slot>,
+}
+
+/// Synchronization point between one submitter and the service thread.
+struct Slot {
+    result: Mutex<Option<i32>>,
+    ready: Condvar,
+}
+
+/// Future-like handle for a submitted position: [`Pending::wait`] blocks
+/// until the service thread has evaluated the batch the position ended up
+/// in.
+pub struct Pending {
+    slot: Arc<Slot>,
+}
+
+impl Pending {
+    /// Blocks until the result is available.
+    #[must_use]
+    pub fn wait(self) -> i32 {
+        let mut result = self
+            .slot
+            .result
+            .lock()
+            .expect("evaluation service does not poison result locks");
+        loop {
+            match *result {
+                Some(score) => return score,
+                None => {
+                    result = self
+                        .slot
+                        .ready
+                        .wait(result)
+                        .expect("evaluation service does not poison result locks");
+                },
+            }
+        }
+    }
+}
+
+/// State shared between the submitters and the service thread.
+struct Shared {
+    queue: Mutex<Vec<Request>>,
+    /// Signalled when the queue goes non-empty or the service shuts down.
+    available: Condvar,
+    stop: AtomicBool,
+}
+
+/// Handle to the service thread. Dropping it drains the queue and joins the
+/// thread.
+pub struct BatchService {
+    shared: Arc<Shared>,
+    worker: Option<std::thread::JoinHandle<()>>,
+}
+
+impl BatchService {
+    /// Spawns the service thread. `max_batch` caps how many queued requests
+    /// are coalesced into one [`BatchEvaluator::evaluate_batch`] call.
+    #[must_use]
+    pub fn new(mut evaluator: impl BatchEvaluator + 'static, max_batch: usize) -> Self {
+        let max_batch = max_batch.max(1);
+        let shared = Arc::new(Shared {
+            queue: Mutex::new(Vec::new()),
+            available: Condvar::new(),
+            stop: AtomicBool::new(false),
+        });
+        let worker = {
+            let shared = Arc::clone(&shared);
+            std::thread::spawn(move || loop {
+                let mut queue = shared
+                    .queue
+                    .lock()
+                    .expect("evaluation service does not poison the queue lock");
+                while queue.is_empty() && !shared.stop.load(Ordering::Acquire) {
+                    queue = shared
+                        .available
+                        .wait(queue)
+                        .expect("evaluation service does not poison the queue lock");
+                }
+                if queue.is_empty() {
+                    // Stop was requested and there is nothing left to serve.
+                    return;
+                }
+                // Coalesce everything that piled up while the previous batch
+                // was being evaluated.
+                let batch_size = queue.len().min(max_batch);
+                let batch: Vec<Request> = queue.drain(..batch_size).collect();
+                drop(queue);
+                let positions: Vec<Position> =
+                    batch.iter().map(|request| request.position.clone()).collect();
+                let results = evaluator.evaluate_batch(&positions);
+                debug_assert_eq!(results.len(), batch.len());
+                for (request, score) in batch.iter().zip(results) {
+                    *request
+                        .slot
+                        .result
+                        .lock()
+                        .expect("evaluation service does not poison result locks") = Some(score);
+                    request.slot.ready.notify_all();
+                }
+            })
+        };
+        Self {
+            shared,
+            worker: Some(worker),
+        }
+    }
+
+    /// Queues a position for evaluation and returns the handle to park on.
+    #[must_use]
+    pub fn submit(&self, position: Position) -> Pending {
+        let slot = Arc::new(Slot {
+            result: Mutex::new(None),
+            ready: Condvar::new(),
+        });
+        self.shared
+            .queue
+            .lock()
+            .expect("evaluation service does not poison the queue lock")
+            .push(Request {
+                position,
+                slot: Arc::clone(&slot),
+            });
+        self.shared.available.notify_one();
+        Pending { slot }
+    }
+}
+
+impl Drop for BatchService {
+    fn drop(&mut self) {
+        self.shared.stop.store(true, Ordering::Release);
+        self.shared.available.notify_all();
+        if let Some(worker) = self.worker.take() {
+            let _ = worker.join();
+        }
+    }
+}
@@ -0,0 +1,209 @@
+//! Fixed-size probe-once caches in front of evaluation. In real game trees
+//! a large share of evaluated positions are transpositions of each other or
+//! share their pawn structure with a sibling: the *evaluation cache* (keyed
+//! by the incremental position Zobrist key) lets transposed positions skip
+//! the network entirely, and the *pawn key* (derived from the pawn
+//! bitboards alone) lets structure-dependent terms be reused across
+//! positions whose pieces differ but whose pawns do not. Both caches are
+//! direct-mapped and always-replace: one probe, one possible L2 hit, no
+//! replacement bookkeeping.
+//!
+//! The slots use the same [lockless XOR trick] as the transposition table,
+//! so any number of threads can probe and store concurrently without locks.
+//!
+//! [lockless XOR trick]: https://www.chessprogramming.org/Shared_Hash_Table#Lock-less
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
+
+use crate::chess::core::{Move, PieceKind, Player};
+use crate::chess::position::Position;
+use crate::evaluation::evaluator::Evaluator;
+
+/// A single cache slot: `key ^ data` and `data`, so a torn concurrent write
+/// fails verification instead of yielding a corrupt score.
+#[derive(Default)]
+struct Slot {
+    key: AtomicU64,
+    data: AtomicU64,
+}
+
+/// Direct-mapped score cache: maps a 64-bit key to an `i32` score. Used
+/// both as the full-evaluation cache (keyed by [`Position::hash`]) and as
+/// the pawn-structure cache (keyed by [`pawn_key`]).
+pub struct ScoreCache {
+    slots: Box<[Slot]>,
+    /// `slots.len() - 1`; the number of slots is a power of two.
+    mask: usize,
+}
+
+/// Tag bit distinguishing a stored score of zero from an empty slot.
+const OCCUPIED: u64 = 1 << 32;
+
+impl ScoreCache {
+    /// Creates a cache occupying at most `size_mb` megabytes, rounding the
+    /// number of slots down to a power of two. Power-of-two sizes are
+    /// already whole slot counts and are used in full.
+    #[must_use]
+    pub fn new(size_mb: usize) -> Self {
+        let slots = 1 << (size_mb * 1024 * 1024 / size_of::<Slot>()).max(1).ilog2();
+        let slots: Box<[Slot]> = std::iter::repeat_with(Slot::default).take(slots).collect();
+        Self {
+            mask: slots.len() - 1,
+            slots,
+        }
+    }
+
+    /// Returns the cached score for `key`, or `None` on a miss or a torn
+    /// slot.
+    #[must_use]
+    pub fn probe(&self, key: u64) -> Option<i32> {
+        crate::stats::record(crate::stats::Event::EvalCacheProbes, 1);
+        let slot = &self.slots[key as usize & self.mask];
+        let data = slot.data.load(Ordering::Relaxed);
+        if slot.key.load(Ordering::Relaxed) ^ data != key || data & OCCUPIED == 0 {
+            return None;
+        }
+        crate::stats::record(crate::stats::Event::EvalCacheHits, 1);
+        Some(data as u32 as i32)
+    }
+
+    /// Stores the score for `key`, unconditionally replacing whatever the
+    /// slot held.
+    pub fn store(&self, key: u64, score: i32) {
+        let slot = &self.slots[key as usize & self.mask];
+        let data = u64::from(score as u32) | OCCUPIED;
+        slot.key.store(key ^ data, Ordering::Relaxed);
+        slot.data.store(data, Ordering::Relaxed);
+    }
+
+    /// Drops all cached scores.
+    pub fn clear(&self) {
+        for slot in self.slots.iter() {
+            slot.key.store(0, Ordering::Relaxed);
+            slot.data.store(0, Ordering::Relaxed);
+        }
+    }
+}
+
+/// Key of the position's pawn structure: depends on the two pawn bitboards
+/// and nothing else, so positions sharing a structure share the key. The
+/// bitboards are mixed through two rounds of the SplitMix64 finalizer,
+/// which is enough to decorrelate the slot index from raw pawn placement.
+#[must_use]
+pub fn pawn_key(position: &Position) -> u64 {
+    let mut key = mix(position.occupied_by(Player::White, PieceKind::Pawn).bits());
+    key ^= mix(position.occupied_by(Player::Black, PieceKind::Pawn).bits().rotate_left(1));
+    key
+}
+
+fn mix(mut value: u64) -> u64 {
+    value = (value ^ (value >> 30)).wrapping_mul(0xBF58_476D_1CE4_E5B9);
+    value = (value ^ (value >> 27)).wrapping_mul(0x94D0_49BB_1331_11EB);
+    value ^ (value >> 31)
+}
+
+/// Evaluator wrapper that consults a shared [`ScoreCache`] before running
+/// the wrapped evaluator. The cache is behind an [`Arc`] so that all search
+/// threads hit the same one.
+pub struct Cached<E> {
+    evaluator: E,
+    cache: Arc<ScoreCache>,
+}
+
+impl<E> Cached<E> {
+    #[allow(missing_docs)]
+    #[must_use]
+    pub fn new(evaluator: E, cache: Arc<ScoreCache>) -> Self {
+        Self { evaluator, cache }
+    }
+}
+
+impl<E: Evaluator> Evaluator for Cached<E> {
+    fn reset(&mut self, position: &Position) {
+        self.evaluator.reset(position);
+    }
+
+    fn make_move(&mut self, position: &Position, next_move: &Move) {
+        self.evaluator.make_move(position, next_move);
+    }
+
+    fn unmake_move(&mut self) {
+        self.evaluator.unmake_move();
+    }
+
+    fn evaluate(&mut self, position: &Position) -> i32 {
+        if let Some(score) = self.cache.probe(position.hash()) {
+            return score;
+        }
+        let score = self.evaluator.evaluate(position);
+        self.cache.store(position.hash(), score);
+        score
+    }
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn probe_and_store() {
+        let cache = ScoreCache::new(1);
+        assert!(cache.probe(0xDEAD_BEEF).is_none());
+        cache.store(0xDEAD_BEEF, -42);
+        assert_eq!(cache.probe(0xDEAD_BEEF), Some(-42));
+        // A score of zero is distinguishable from an empty slot.
+        cache.store(0xDEAD_BEEF, 0);
+        assert_eq!(cache.probe(0xDEAD_BEEF), Some(0));
+        // A different key mapping to the same slot fails verification.
+        assert!(cache.probe(0xDEAD_BEEF ^ 0x8000_0000_0000_0000).is_none());
+        cache.clear();
+        assert!(cache.probe(0xDEAD_BEEF).is_none());
+    }
+
+    #[test]
+    fn pawn_key_depends_on_pawns_only() {
+        let position = Position::starting();
+        // Same pawns, different pieces: the structure key must match.
+        let shuffled =
+            Position::from_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBRN w Qkq - 0 1").unwrap();
+        assert_eq!(pawn_key(&position), pawn_key(&shuffled));
+        assert_ne!(position.hash(), shuffled.hash());
+        // Moving a pawn changes the key...
+        let pushed =
+            Position::from_fen("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1")
+                .unwrap();
+        assert_ne!(pawn_key(&position), pawn_key(&pushed));
+        // ...and mirrored pawn structures do not collide either.
+        let white_pawn = Position::from_fen("4k3/8/8/8/8/8/4P3/4K3 w - - 0 1").unwrap();
+        let black_pawn = Position::from_fen("4k3/4p3/8/8/8/8/8/4K3 w - - 0 1").unwrap();
+        assert_ne!(pawn_key(&white_pawn), pawn_key(&black_pawn));
+    }
+
+    struct Counter(usize);
+
+    impl Evaluator for Counter {
+        fn reset(&mut self, _position: &Position) {}
+
+        fn make_move(&mut self, _position: &Position, _next_move: &Move) {}
+
+        fn unmake_move(&mut self) {}
+
+        fn evaluate(&mut self, _position: &Position) -> i32 {
+            self.0 += 1;
+            self.0 as i32
+        }
+    }
+
+    #[test]
+    fn cached_evaluator_skips_recomputation() {
+        let cache = Arc::new(ScoreCache::new(1));
+        let mut evaluator = Cached::new(Counter(0), Arc::clone(&cache));
+        let position = Position::starting();
+        evaluator.reset(&position);
+        let first = evaluator.evaluate(&position);
+        // The second evaluation of a transposed (here: identical) position
+        // is served from the cache.
+        assert_eq!(evaluator.evaluate(&position), first);
+        assert_eq!(evaluator.evaluator.0, 1);
+    }
+}
@@ -1 +1,26 @@
-pub trait Evaluator {}
+//! Interface between the search and static position evaluation. The search
+//! mirrors its make/unmake calls to the evaluator, so implementations can
+//! maintain their state incrementally instead of recomputing it for every
+//! probed position.
+use crate::chess::core::Move;
+use crate::chess::position::Position;
+
+/// Static evaluator of a single position, without any lookahead.
+pub trait Evaluator {
+    /// Rebuilds the internal state for a new root `position`. Must be called
+    /// before the first [`Evaluator::evaluate`] and whenever the search jumps
+    /// to an unrelated position.
+    fn reset(&mut self, position: &Position);
+
+    /// Notifies the evaluator that `next_move` is about to be played:
+    /// `position` is the state *before* the move, i.e. this should be called
+    /// right before the matching [`Position::make_move`].
+    fn make_move(&mut self, position: &Position, next_move: &Move);
+
+    /// Rolls back the state update of the last [`Evaluator::make_move`].
+    fn unmake_move(&mut self);
+
+    /// Returns the score of the position (which must correspond to the
+    /// make/unmake history) in centipawns, from the side to move perspective.
+    fn evaluate(&mut self, position: &Position) -> i32;
+}
@@ -0,0 +1,351 @@
+//! [NNUE]-style neural evaluator. The expensive first layer is not
+//! recomputed per position: its output (the *accumulator*) is updated
+//! incrementally from make/unmake deltas — a move only adds and removes a
+//! handful of piece-square features, and the [`Pieces`] bitboard layout makes
+//! those deltas trivial to extract. This is what makes neural evaluation
+//! viable at search speeds: a full forward pass per node would cap the search
+//! at tens of thousands of evaluations per second.
+//!
+//! Features are king-bucketed: every piece-square input is replicated per
+//! coarse region of the friendly king, so the network can weigh piece
+//! placement differently depending on where the king lives. The price is
+//! that a king move invalidates the whole perspective; the accumulator is
+//! then rebuilt lazily on the next evaluation instead of eagerly on the
+//! move, which keeps make/unmake cheap along lines the search never
+//! evaluates.
+//!
+//! The weights come from [`Network::load`]; the training pipeline producing
+//! them is separate, and an untrained [`Network::zeroed`] network evaluates
+//! everything to zero.
+//!
+//! [NNUE]: https://www.chessprogramming.org/NNUE
+//! [`Pieces`]: crate::chess::bitboard
+use std::fs;
+use std::path::Path;
+
+use anyhow::{bail, Context};
+
+use crate::chess::core::{File, Move, Piece, PieceKind, Player, Square, BOARD_SIZE};
+use crate::chess::position::Position;
+use crate::evaluation::evaluator::Evaluator;
+use crate::evaluation::simd;
+
+/// Width of the accumulator: the number of first-layer neurons per
+/// perspective.
+const HIDDEN: usize = 256;
+/// Number of coarse king regions (board quadrants from the perspective of
+/// the king's owner). More buckets make the evaluation more king-aware at
+/// the cost of a bigger network and more frequent full refreshes.
+const KING_BUCKETS: usize = 4;
+/// Piece-square planes: 6 piece kinds for each of the two players.
+const PIECE_PLANES: usize = 12;
+/// Total first-layer inputs per perspective.
+const INPUTS: usize = KING_BUCKETS * PIECE_PLANES * BOARD_SIZE as usize;
+
+/// The raw network output is divided by this to produce centipawns. The
+/// exact quantization scheme is fixed by the training pipeline; this value
+/// only has to match the one used when the weights were quantized.
+const OUTPUT_SCALE: i32 = 64;
+
+/// First-layer and output weights of the network, quantized to 16 bits.
+#[derive(Clone)]
+pub struct Network {
+    /// `INPUTS * HIDDEN` weights, laid out feature-major so that one
+    /// feature's contribution to the whole accumulator is a contiguous
+    /// stripe (the unit of work of an incremental add/subtract).
+    feature_weights: Box<[i16]>,
+    /// `HIDDEN` biases the accumulator starts from.
+    feature_biases: Box<[i16]>,
+    /// `2 * HIDDEN` output weights: first the side to move perspective, then
+    /// the opponent's.
+    output_weights: Box<[i16]>,
+    output_bias: i32,
+}
+
+impl Network {
+    /// Size of the serialized network in bytes: all weights as little-endian
+    /// 16-bit integers, then the 32-bit output bias.
+    pub const SIZE_BYTES: usize = (INPUTS * HIDDEN + HIDDEN + 2 * HIDDEN) * 2 + 4;
+
+    /// Creates a network with all weights at zero: evaluates any position to
+    /// exactly zero. Useful as a placeholder until trained weights are
+    /// available.
+    #[must_use]
+    pub fn zeroed() -> Self {
+        Self {
+            feature_weights: vec![0; INPUTS * HIDDEN].into_boxed_slice(),
+            feature_biases: vec![0; HIDDEN].into_boxed_slice(),
+            output_weights: vec![0; 2 * HIDDEN].into_boxed_slice(),
+            output_bias: 0,
+        }
+    }
+
+    /// Deserializes a network from the format described in
+    /// [`Network::SIZE_BYTES`].
+    ///
+    /// # Errors
+    ///
+    /// Returns an error if the buffer size does not match the architecture.
+    pub fn from_bytes(bytes: &[u8]) -> anyhow::Result<Self> {
+        if bytes.len() != Self::SIZE_BYTES {
+            bail!(
+                "network size mismatch: expected {} bytes, got {}",
+                Self::SIZE_BYTES,
+                bytes.len()
+            );
+        }
+        let mut words = bytes
+            .chunks_exact(2)
+            .map(|chunk| i16::from_le_bytes([chunk[0], chunk[1]]));
+        let mut read = |count: usize| -> Box<[i16]> { words.by_ref().take(count).collect() };
+        let feature_weights = read(INPUTS * HIDDEN);
+        let feature_biases = read(HIDDEN);
+        let output_weights = read(2 * HIDDEN);
+        let bias_bytes = &bytes[Self::SIZE_BYTES - 4..];
+        Ok(Self {
+            feature_weights,
+            feature_biases,
+            output_weights,
+            output_bias: i32::from_le_bytes(bias_bytes.try_into().unwrap()),
+        })
+    }
+
+    /// Reads a network from a weight file.
+    ///
+    /// # Errors
+    ///
+    /// Returns an error if the file can not be read or has the wrong size.
+    pub fn load(path: impl AsRef<Path>) -> anyhow::Result<Self> {
+        let bytes = fs::read(path.as_ref())
+            .with_context(|| format!("can not read network {}", path.as_ref().display()))?;
+        Self::from_bytes(&bytes)
+            .with_context(|| format!("malformed network {}", path.as_ref().display()))
+    }
+
+    /// Stripe of first-layer weights activated by one feature.
+    fn feature(&self, index: usize) -> &[i16] {
+        &self.feature_weights[index * HIDDEN..(index + 1) * HIDDEN]
+    }
+}
+
+/// First-layer output for both perspectives at one ply of the search, plus
+/// the bookkeeping needed to update it.
+#[derive(Clone)]
+struct Accumulator {
+    /// Accumulated first-layer sums, indexed by perspective.
+    values: [[i16; HIDDEN]; 2],
+    /// King square per perspective: determines the feature bucket.
+    kings: [Square; 2],
+    /// Whether `values` of the perspective are up to date. A king move
+    /// changes the bucket of *every* feature of its perspective, so instead
+    /// of an O(pieces) delta the perspective is marked stale and rebuilt
+    /// lazily by the next evaluation.
+    fresh: [bool; 2],
+}
+
+impl Accumulator {
+    fn stale() -> Self {
+        Self {
+            values: [[0; HIDDEN]; 2],
+            kings: [Square::E1, Square::E8],
+            fresh: [false, false],
+        }
+    }
+}
+
+/// NNUE evaluator: a [`Network`] plus a stack of accumulators mirroring the
+/// search's make/unmake stack.
+pub struct Nnue {
+    network: Network,
+    stack: Vec<Accumulator>,
+}
+
+impl Nnue {
+    /// Creates an evaluator driven by the given network.
+    #[must_use]
+    pub fn new(network: Network) -> Self {
+        Self {
+            network,
+            stack: vec![Accumulator::stale()],
+        }
+    }
+
+    fn top(&mut self) -> &mut Accumulator {
+        self.stack.last_mut().expect("accumulator stack is never empty")
+    }
+
+    /// Adds (`SIGN = 1`) or subtracts (`SIGN = -1`) one piece-square feature
+    /// from the perspective's accumulator.
+    fn apply<const SIGN: i16>(&mut self, perspective: usize, piece: &Piece, square: Square) {
+        let accumulator = self.stack.last_mut().expect("accumulator stack is never empty");
+        let index = feature_index(perspective, accumulator.kings[perspective], piece, square);
+        let stripe = self.network.feature(index);
+        if SIGN == 1 {
+            simd::add_assign_i16(&mut accumulator.values[perspective], stripe);
+        } else {
+            simd::sub_assign_i16(&mut accumulator.values[perspective], stripe);
+        }
+    }
+
+    /// Rebuilds the perspective's accumulator from scratch for `position`.
+    fn refresh(&mut self, perspective: usize, position: &Position) {
+        let mut king = None;
+        for index in 0..BOARD_SIZE {
+            let square = Square::try_from(index).expect("board index is a valid square");
+            if let Some(piece) = position.at(square) {
+                if piece.kind == PieceKind::King && perspective_index(piece.owner) == perspective {
+                    king = Some(square);
+                }
+            }
+        }
+        let king = king.expect("a legal position has exactly one king per player");
+        let accumulator = self.stack.last_mut().expect("accumulator stack is never empty");
+        accumulator.kings[perspective] = king;
+        accumulator.values[perspective].copy_from_slice(&self.network.feature_biases);
+        for index in 0..BOARD_SIZE {
+            let square = Square::try_from(index).expect("board index is a valid square");
+            if let Some(piece) = position.at(square) {
+                let feature = feature_index(perspective, king, &piece, square);
+                simd::add_assign_i16(
+                    &mut accumulator.values[perspective],
+                    self.network.feature(feature),
+                );
+            }
+        }
+        accumulator.fresh[perspective] = true;
+    }
+}
+
+impl Evaluator for Nnue {
+    fn reset(&mut self, _position: &Position) {
+        self.stack.clear();
+        self.stack.push(Accumulator::stale());
+    }
+
+    fn make_move(&mut self, position: &Position, next_move: &Move) {
+        let (from, to) = (next_move.from_square(), next_move.to_square());
+        let mover = position
+            .at(from)
+            .expect("make_move is called with a legal move");
+        let captured = position.at(to);
+        let next = self.top().clone();
+        self.stack.push(next);
+        for perspective in 0..2 {
+            if !self.top().fresh[perspective] {
+                continue;
+            }
+            if mover.kind == PieceKind::King && perspective_index(mover.owner) == perspective {
+                // The king bucket of this perspective changes: *every* one of
+                // its features moves. Mark it stale and rebuild lazily on the
+                // next evaluation instead of an O(pieces) update here.
+                self.top().fresh[perspective] = false;
+                continue;
+            }
+            self.apply::<-1>(perspective, &mover, from);
+            let landed = Piece {
+                owner: mover.owner,
+                kind: match next_move.promotion() {
+                    Some(promotion) => promotion.into(),
+                    None => mover.kind,
+                },
+            };
+            self.apply::<1>(perspective, &landed, to);
+            if let Some(victim) = &captured {
+                self.apply::<-1>(
+                    perspective,
+                    &Piece {
+                        owner: victim.owner,
+                        kind: victim.kind,
+                    },
+                    to,
+                );
+            } else if mover.kind == PieceKind::Pawn && from.file() != to.file() {
+                // A pawn capturing an empty square is en passant: the victim
+                // stands beside the destination.
+                self.apply::<-1>(
+                    perspective,
+                    &Piece {
+                        owner: mover.owner.opponent(),
+                        kind: PieceKind::Pawn,
+                    },
+                    Square::new(to.file(), from.rank()),
+                );
+            } else if mover.kind == PieceKind::King && from.file() == File::E {
+                // Castling (seen by the opponent's perspective: the king's
+                // owner went through the refresh path above). The king moves
+                // two files, which no regular king move can do.
+                let (rook_from, rook_to) = match to.file() {
+                    File::G => (File::H, File::F),
+                    File::C => (File::A, File::D),
+                    _ => continue,
+                };
+                let rook = Piece {
+                    owner: mover.owner,
+                    kind: PieceKind::Rook,
+                };
+                self.apply::<-1>(perspective, &rook, Square::new(rook_from, from.rank()));
+                self.apply::<1>(perspective, &rook, Square::new(rook_to, from.rank()));
+            }
+        }
+    }
+
+    fn unmake_move(&mut self) {
+        let _ = self.stack.pop();
+        debug_assert!(!self.stack.is_empty());
+    }
+
+    fn evaluate(&mut self, position: &Position) -> i32 {
+        for perspective in 0..2 {
+            if !self.top().fresh[perspective] {
+                self.refresh(perspective, position);
+            }
+        }
+        let accumulator = self.stack.last().expect("accumulator stack is never empty");
+        let us = perspective_index(position.side_to_move());
+        let mut output = self.network.output_bias;
+        for (half, perspective) in [(0, us), (1, 1 - us)] {
+            let weights = &self.network.output_weights[half * HIDDEN..(half + 1) * HIDDEN];
+            output += simd::crelu_dot_i16(&accumulator.values[perspective], weights);
+        }
+        output / OUTPUT_SCALE
+    }
+}
+
+impl crate::evaluation::batch::BatchEvaluator for Nnue {
+    /// Evaluates the batch position by position for now: the batched SIMD
+    /// forward pass will slot in here, but even sequentially the service
+    /// unblocks all submitters in one go.
+    fn evaluate_batch(&mut self, positions: &[Position]) -> Vec<i32> {
+        positions
+            .iter()
+            .map(|position| {
+                self.reset(position);
+                self.evaluate(position)
+            })
+            .collect()
+    }
+}
+
+fn perspective_index(player: Player) -> usize {
+    match player {
+        Player::White => 0,
+        Player::Black => 1,
+    }
+}
+
+/// Index of the first-layer input activated by `piece` standing on `square`,
+/// as seen from `perspective` whose king is on `king`. Black's perspective
+/// mirrors the board vertically so that both players share the same weights.
+fn feature_index(perspective: usize, king: Square, piece: &Piece, square: Square) -> usize {
+    let orient = |square: Square| -> usize {
+        match perspective {
+            0 => square as usize,
+            _ => square as usize ^ 56,
+        }
+    };
+    let king = orient(king);
+    let bucket = usize::from(king % 8 >= 4) + 2 * usize::from(king / 8 >= 4);
+    let friendly = usize::from(perspective_index(piece.owner) != perspective);
+    let plane = (piece.kind as usize - 1) * 2 + friendly;
+    (bucket * PIECE_PLANES + plane) * BOARD_SIZE as usize + orient(square)
+}
@@ -0,0 +1,408 @@
+//! Explicitly vectorized kernels for the hot evaluation math: expanding
+//! [`Position`] bitboards into dense feature planes and the integer
+//! dense-layer arithmetic of the network. Autovectorization does not
+//! reliably deliver on this kind of code, so the kernels are written with
+//! AVX2 intrinsics directly, with an AVX-512 path behind the `avx512` cargo
+//! feature and a scalar fallback for everything else. Like the PEXT/magic
+//! split in move generation, the dispatch is resolved at compile time from
+//! the enabled target features: either branch is dead code on a given build.
+use crate::chess::core::{PieceKind, Player};
+use crate::chess::position::Position;
+
+/// Number of feature planes of one position: 6 piece kinds per player.
+pub const PLANES: usize = 12;
+
+/// Expands the position's piece bitboards into `PLANES` 64-byte 0/1 planes,
+/// ordered white king..pawn, then black king..pawn. This is the input layout
+/// of batched (non-incremental) network inference and of training data
+/// export.
+pub fn expand_planes(position: &Position, planes: &mut [u8; PLANES * 64]) {
+    let mut offset = 0;
+    for player in [Player::White, Player::Black] {
+        for kind in [
+            PieceKind::King,
+            PieceKind::Queen,
+            PieceKind::Rook,
+            PieceKind::Bishop,
+            PieceKind::Knight,
+            PieceKind::Pawn,
+        ] {
+            expand_bits(
+                position.occupied_by(player, kind).bits(),
+                (&mut planes[offset..offset + 64]).try_into().unwrap(),
+            );
+            offset += 64;
+        }
+    }
+}
+
+/// Expands a 64-bit mask into 64 bytes: `out[i] = (mask >> i) & 1`.
+pub fn expand_bits(mask: u64, out: &mut [u8; 64]) {
+    #[cfg(target_arch = "x86_64")]
+    if cfg!(target_feature = "avx2") {
+        unsafe { x86::expand_bits_avx2(mask, out) };
+        return;
+    }
+    for (index, byte) in out.iter_mut().enumerate() {
+        *byte = ((mask >> index) & 1) as u8;
+    }
+}
+
+/// Adds the weight stripe to the accumulator element-wise. The slice
+/// lengths must match and be a multiple of 32.
+pub fn add_assign_i16(accumulator: &mut [i16], weights: &[i16]) {
+    debug_assert_eq!(accumulator.len(), weights.len());
+    debug_assert_eq!(accumulator.len() % 32, 0);
+    #[cfg(all(target_arch = "x86_64", feature = "avx512"))]
+    if cfg!(target_feature = "avx512bw") {
+        unsafe { x86::add_assign_i16_avx512(accumulator, weights) };
+        return;
+    }
+    #[cfg(target_arch = "x86_64")]
+    if cfg!(target_feature = "avx2") {
+        unsafe { x86::add_assign_i16_avx2(accumulator, weights) };
+        return;
+    }
+    for (value, weight) in accumulator.iter_mut().zip(weights) {
+        *value = value.wrapping_add(*weight);
+    }
+}
+
+/// Subtracts the weight stripe from the accumulator element-wise. The slice
+/// lengths must match and be a multiple of 32.
+pub fn sub_assign_i16(accumulator: &mut [i16], weights: &[i16]) {
+    debug_assert_eq!(accumulator.len(), weights.len());
+    debug_assert_eq!(accumulator.len() % 32, 0);
+    #[cfg(all(target_arch = "x86_64", feature = "avx512"))]
+    if cfg!(target_feature = "avx512bw") {
+        unsafe { x86::sub_assign_i16_avx512(accumulator, weights) };
+        return;
+    }
+    #[cfg(target_arch = "x86_64")]
+    if cfg!(target_feature = "avx2") {
+        unsafe { x86::sub_assign_i16_avx2(accumulator, weights) };
+        return;
+    }
+    for (value, weight) in accumulator.iter_mut().zip(weights) {
+        *value = value.wrapping_sub(*weight);
+    }
+}
+
+/// Clips `values` to `[0, 255]` and returns the dot product with `weights`
+/// in 32-bit precision: the output-layer kernel over an accumulator half.
+/// The slice lengths must match and be a multiple of 32.
+#[must_use]
+pub fn crelu_dot_i16(values: &[i16], weights: &[i16]) -> i32 {
+    debug_assert_eq!(values.len(), weights.len());
+    debug_assert_eq!(values.len() % 32, 0);
+    #[cfg(all(target_arch = "x86_64", feature = "avx512"))]
+    if cfg!(target_feature = "avx512bw") {
+        return unsafe { x86::crelu_dot_i16_avx512(values, weights) };
+    }
+    #[cfg(target_arch = "x86_64")]
+    if cfg!(target_feature = "avx2") {
+        return unsafe { x86::crelu_dot_i16_avx2(values, weights) };
+    }
+    values
+        .iter()
+        .zip(weights)
+        .map(|(value, weight)| i32::from((*value).clamp(0, 255)) * i32::from(*weight))
+        .sum()
+}
+
+/// Dense int8 layer: `output[row] = biases[row] + input · weights[row]`,
+/// with unsigned 8-bit activations and signed 8-bit weights laid out
+/// row-major. The input length must be a multiple of 64. Adjacent weight
+/// pairs must not overflow the intermediate 16-bit sums (the quantizer
+/// guarantees this), matching the semantics of the underlying `maddubs`
+/// instruction.
+pub fn dense_i8(input: &[u8], weights: &[i8], biases: &[i32], output: &mut [i32]) {
+    debug_assert_eq!(weights.len(), input.len() * output.len());
+    debug_assert_eq!(biases.len(), output.len());
+    debug_assert_eq!(input.len() % 64, 0);
+    for (row, out) in output.iter_mut().enumerate() {
+        let row_weights = &weights[row * input.len()..(row + 1) * input.len()];
+        *out = biases[row] + dot_i8(input, row_weights);
+    }
+}
+
+fn dot_i8(input: &[u8], weights: &[i8]) -> i32 {
+    #[cfg(all(target_arch = "x86_64", feature = "avx512"))]
+    if cfg!(target_feature = "avx512bw") {
+        return unsafe { x86::dot_i8_avx512(input, weights) };
+    }
+    #[cfg(target_arch = "x86_64")]
+    if cfg!(target_feature = "avx2") {
+        return unsafe { x86::dot_i8_avx2(input, weights) };
+    }
+    input
+        .iter()
+        .zip(weights)
+        .map(|(activation, weight)| i32::from(*activation) * i32::from(*weight))
+        .sum()
+}
+
+#[cfg(target_arch = "x86_64")]
+mod x86 {
+    use core::arch::x86_64::{
+        __m256i,
+        _mm256_add_epi16,
+        _mm256_add_epi32,
+        _mm256_and_si256,
+        _mm256_cmpeq_epi8,
+        _mm256_loadu_si256,
+        _mm256_madd_epi16,
+        _mm256_maddubs_epi16,
+        _mm256_max_epi16,
+        _mm256_min_epi16,
+        _mm256_set1_epi16,
+        _mm256_set1_epi32,
+        _mm256_set1_epi8,
+        _mm256_setr_epi8,
+        _mm256_setzero_si256,
+        _mm256_storeu_si256,
+        _mm256_sub_epi16,
+    };
+
+    #[target_feature(enable = "avx2")]
+    pub(super) unsafe fn expand_bits_avx2(mask: u64, out: &mut [u8; 64]) {
+        // Bit i of the mask lands in byte i: replicate the relevant 32 bits
+        // into every dword, shuffle each mask byte across 8 output bytes and
+        // compare against the per-lane bit selectors.
+        let selector = _mm256_setr_epi8(
+            1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64,
+            -128, 1, 2, 4, 8, 16, 32, 64, -128,
+        );
+        let spread = _mm256_setr_epi8(
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3,
+            3, 3, 3, 3,
+        );
+        for half in 0..2 {
+            let bits = _mm256_set1_epi32((mask >> (32 * half)) as u32 as i32);
+            let bytes = core::arch::x86_64::_mm256_shuffle_epi8(bits, spread);
+            let selected = _mm256_and_si256(bytes, selector);
+            let ones = _mm256_and_si256(
+                _mm256_cmpeq_epi8(selected, selector),
+                _mm256_set1_epi8(1),
+            );
+            _mm256_storeu_si256(out.as_mut_ptr().add(32 * half).cast(), ones);
+        }
+    }
+
+    #[target_feature(enable = "avx2")]
+    pub(super) unsafe fn add_assign_i16_avx2(accumulator: &mut [i16], weights: &[i16]) {
+        for (chunk, weights) in accumulator.chunks_exact_mut(16).zip(weights.chunks_exact(16)) {
+            let sum = _mm256_add_epi16(
+                _mm256_loadu_si256(chunk.as_ptr().cast()),
+                _mm256_loadu_si256(weights.as_ptr().cast()),
+            );
+            _mm256_storeu_si256(chunk.as_mut_ptr().cast(), sum);
+        }
+    }
+
+    #[target_feature(enable = "avx2")]
+    pub(super) unsafe fn sub_assign_i16_avx2(accumulator: &mut [i16], weights: &[i16]) {
+        for (chunk, weights) in accumulator.chunks_exact_mut(16).zip(weights.chunks_exact(16)) {
+            let difference = _mm256_sub_epi16(
+                _mm256_loadu_si256(chunk.as_ptr().cast()),
+                _mm256_loadu_si256(weights.as_ptr().cast()),
+            );
+            _mm256_storeu_si256(chunk.as_mut_ptr().cast(), difference);
+        }
+    }
+
+    #[target_feature(enable = "avx2")]
+    pub(super) unsafe fn crelu_dot_i16_avx2(values: &[i16], weights: &[i16]) -> i32 {
+        let zero = _mm256_setzero_si256();
+        let ceiling = _mm256_set1_epi16(255);
+        let mut sum = _mm256_setzero_si256();
+        for (values, weights) in values.chunks_exact(16).zip(weights.chunks_exact(16)) {
+            let activated = _mm256_min_epi16(
+                _mm256_max_epi16(_mm256_loadu_si256(values.as_ptr().cast()), zero),
+                ceiling,
+            );
+            sum = _mm256_add_epi32(
+                sum,
+                _mm256_madd_epi16(activated, _mm256_loadu_si256(weights.as_ptr().cast())),
+            );
+        }
+        horizontal_sum(sum)
+    }
+
+    #[target_feature(enable = "avx2")]
+    pub(super) unsafe fn dot_i8_avx2(input: &[u8], weights: &[i8]) -> i32 {
+        let ones = _mm256_set1_epi16(1);
+        let mut sum = _mm256_setzero_si256();
+        for (input, weights) in input.chunks_exact(32).zip(weights.chunks_exact(32)) {
+            let pairs = _mm256_maddubs_epi16(
+                _mm256_loadu_si256(input.as_ptr().cast()),
+                _mm256_loadu_si256(weights.as_ptr().cast()),
+            );
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(pairs, ones));
+        }
+        horizontal_sum(sum)
+    }
+
+    #[target_feature(enable = "avx2")]
+    unsafe fn horizontal_sum(vector: __m256i) -> i32 {
+        let mut lanes = [0i32; 8];
+        _mm256_storeu_si256(lanes.as_mut_ptr().cast(), vector);
+        lanes.iter().sum()
+    }
+
+    #[cfg(feature = "avx512")]
+    mod avx512 {
+        use core::arch::x86_64::{
+            _mm512_add_epi16,
+            _mm512_add_epi32,
+            _mm512_loadu_si512,
+            _mm512_madd_epi16,
+            _mm512_maddubs_epi16,
+            _mm512_max_epi16,
+            _mm512_min_epi16,
+            _mm512_reduce_add_epi32,
+            _mm512_set1_epi16,
+            _mm512_setzero_si512,
+            _mm512_storeu_si512,
+            _mm512_sub_epi16,
+        };
+
+        #[target_feature(enable = "avx512bw")]
+        pub(in super::super) unsafe fn add_assign_i16_avx512(
+            accumulator: &mut [i16],
+            weights: &[i16],
+        ) {
+            for (chunk, weights) in
+                accumulator.chunks_exact_mut(32).zip(weights.chunks_exact(32))
+            {
+                let sum = _mm512_add_epi16(
+                    _mm512_loadu_si512(chunk.as_ptr().cast()),
+                    _mm512_loadu_si512(weights.as_ptr().cast()),
+                );
+                _mm512_storeu_si512(chunk.as_mut_ptr().cast(), sum);
+            }
+        }
+
+        #[target_feature(enable = "avx512bw")]
+        pub(in super::super) unsafe fn sub_assign_i16_avx512(
+            accumulator: &mut [i16],
+            weights: &[i16],
+        ) {
+            for (chunk, weights) in
+                accumulator.chunks_exact_mut(32).zip(weights.chunks_exact(32))
+            {
+                let difference = _mm512_sub_epi16(
+                    _mm512_loadu_si512(chunk.as_ptr().cast()),
+                    _mm512_loadu_si512(weights.as_ptr().cast()),
+                );
+                _mm512_storeu_si512(chunk.as_mut_ptr().cast(), difference);
+            }
+        }
+
+        #[target_feature(enable = "avx512bw")]
+        pub(in super::super) unsafe fn crelu_dot_i16_avx512(
+            values: &[i16],
+            weights: &[i16],
+        ) -> i32 {
+            let zero = _mm512_setzero_si512();
+            let ceiling = _mm512_set1_epi16(255);
+            let mut sum = _mm512_setzero_si512();
+            for (values, weights) in values.chunks_exact(32).zip(weights.chunks_exact(32)) {
+                let activated = _mm512_min_epi16(
+                    _mm512_max_epi16(_mm512_loadu_si512(values.as_ptr().cast()), zero),
+                    ceiling,
+                );
+                sum = _mm512_add_epi32(
+                    sum,
+                    _mm512_madd_epi16(activated, _mm512_loadu_si512(weights.as_ptr().cast())),
+                );
+            }
+            _mm512_reduce_add_epi32(sum)
+        }
+
+        #[target_feature(enable = "avx512bw")]
+        pub(in super::super) unsafe fn dot_i8_avx512(input: &[u8], weights: &[i8]) -> i32 {
+            let ones = _mm512_set1_epi16(1);
+            let mut sum = _mm512_setzero_si512();
+            for (input, weights) in input.chunks_exact(64).zip(weights.chunks_exact(64)) {
+                let pairs = _mm512_maddubs_epi16(
+                    _mm512_loadu_si512(input.as_ptr().cast()),
+                    _mm512_loadu_si512(weights.as_ptr().cast()),
+                );
+                sum = _mm512_add_epi32(sum, _mm512_madd_epi16(pairs, ones));
+            }
+            _mm512_reduce_add_epi32(sum)
+        }
+    }
+
+    #[cfg(feature = "avx512")]
+    pub(super) use avx512::*;
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    // Deterministic pseudo-random stream for exercising the kernels.
+    fn lcg(state: &mut u64) -> u64 {
+        *state = state
+            .wrapping_mul(6_364_136_223_846_793_005)
+            .wrapping_add(1_442_695_040_888_963_407);
+        *state >> 16
+    }
+
+    #[test]
+    fn expand_bits_matches_reference() {
+        let mut state = 42;
+        for _ in 0..100 {
+            let mask = lcg(&mut state);
+            let mut out = [0u8; 64];
+            expand_bits(mask, &mut out);
+            for (index, byte) in out.iter().enumerate() {
+                assert_eq!(u64::from(*byte), (mask >> index) & 1, "mask {mask:#x}");
+            }
+        }
+    }
+
+    #[test]
+    fn accumulator_kernels_match_reference() {
+        let mut state = 7;
+        let mut accumulator: Vec<i16> = (0..256).map(|_| lcg(&mut state) as i16 % 500).collect();
+        let weights: Vec<i16> = (0..256).map(|_| lcg(&mut state) as i16 % 100).collect();
+        let mut expected = accumulator.clone();
+        add_assign_i16(&mut accumulator, &weights);
+        for (value, weight) in expected.iter_mut().zip(&weights) {
+            *value += weight;
+        }
+        assert_eq!(accumulator, expected);
+        sub_assign_i16(&mut accumulator, &weights);
+        for (value, weight) in expected.iter_mut().zip(&weights) {
+            *value -= weight;
+        }
+        assert_eq!(accumulator, expected);
+        let expected_dot: i32 = accumulator
+            .iter()
+            .zip(&weights)
+            .map(|(value, weight)| i32::from((*value).clamp(0, 255)) * i32::from(*weight))
+            .sum();
+        assert_eq!(crelu_dot_i16(&accumulator, &weights), expected_dot);
+    }
+
+    #[test]
+    fn dense_i8_matches_reference() {
+        let mut state = 9;
+        let input: Vec<u8> = (0..128).map(|_| lcg(&mut state) as u8 % 64).collect();
+        let weights: Vec<i8> = (0..128 * 4).map(|_| (lcg(&mut state) as i8) % 32).collect();
+        let biases = [1, -2, 3, -4];
+        let mut output = [0i32; 4];
+        dense_i8(&input, &weights, &biases, &mut output);
+        for row in 0..4 {
+            let expected: i32 = input
+                .iter()
+                .zip(&weights[row * 128..(row + 1) * 128])
+                .map(|(activation, weight)| i32::from(*activation) * i32::from(*weight))
+                .sum();
+            assert_eq!(output[row], biases[row] + expected);
+        }
+    }
+}
@@ -1,3 +1,4 @@
 //! Interface between the engine and the front-end (tournament runner or GUI).
 
+pub mod book;
 pub mod uci;
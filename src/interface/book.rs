@@ -0,0 +1,154 @@
+//! Opening book in the [Polyglot] `.bin` format, probed zero-copy: the file
+//! is memory-mapped and looked up with a binary search directly over the
+//! mapped 16-byte entries, so a multi-hundred-megabyte book costs nothing at
+//! startup, shares its pages between engine processes and answers probes in
+//! microseconds.
+//!
+//! The entry layout, ordering and move encoding are exactly Polyglot's. The
+//! *keys*, however, are this engine's own Zobrist hashes: the reference
+//! Polyglot `Random64` table is not embedded here, so books built by
+//! third-party tools must be re-keyed offline (replaying the lines and
+//! rewriting each entry's key with [`Position::hash`]) before the engine can
+//! find their entries.
+//!
+//! [Polyglot]: http://hgm.nubati.net/book_format.html
+
+use std::fs;
+use std::path::Path;
+
+use anyhow::{bail, Context};
+
+use crate::chess::core::{File, Move, Promotion, Rank, Square};
+use crate::chess::position::Position;
+
+/// Size of one book entry on disk: key, move, weight and learn value.
+const ENTRY_SIZE: usize = 16;
+
+/// A memory-mapped opening book. Entries are sorted by key, ascending — the
+/// format's invariant that makes binary probing possible.
+pub struct Book {
+    map: memmap2::Mmap,
+}
+
+impl Book {
+    /// Maps the book file into memory. The contents are not read (and thus
+    /// not validated) beyond the size check: probing binary-searches the
+    /// mapped pages on demand.
+    ///
+    /// # Errors
+    ///
+    /// Returns an error if the file can not be opened or mapped, or its size
+    /// is not a whole number of entries.
+    pub fn open(path: impl AsRef<Path>) -> anyhow::Result<Self> {
+        let file = fs::File::open(path.as_ref())
+            .with_context(|| format!("can not open book {}", path.as_ref().display()))?;
+        // SAFETY: the mapping is read-only; book files are not expected to
+        // be mutated while the engine reads them.
+        let map = unsafe { memmap2::Mmap::map(&file) }
+            .with_context(|| format!("can not map book {}", path.as_ref().display()))?;
+        if map.len() % ENTRY_SIZE != 0 {
+            bail!(
+                "book {} is corrupt: {} bytes is not a whole number of entries",
+                path.as_ref().display(),
+                map.len()
+            );
+        }
+        Ok(Self { map })
+    }
+
+    /// Number of entries in the book.
+    #[must_use]
+    pub fn len(&self) -> usize {
+        self.map.len() / ENTRY_SIZE
+    }
+
+    /// Checks whether the book has no entries.
+    #[must_use]
+    pub fn is_empty(&self) -> bool {
+        self.map.is_empty()
+    }
+
+    /// Looks up the book move for the position: the highest-weighted legal
+    /// entry under the position's key, or `None` when the position is out of
+    /// book. Entries that do not decode to a legal move are skipped rather
+    /// than trusted.
+    #[must_use]
+    pub fn probe(&self, position: &Position) -> Option<Move> {
+        let key = position.hash();
+        // Leftmost entry with the key: everything before it hashes lower.
+        let mut first = {
+            let (mut low, mut high) = (0, self.len());
+            while low < high {
+                let middle = (low + high) / 2;
+                if self.key_at(middle) < key {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+            low
+        };
+        let legal_moves = position.generate_moves();
+        let mut best: Option<(u16, Move)> = None;
+        while first < self.len() && self.key_at(first) == key {
+            let entry = &self.map[first * ENTRY_SIZE..(first + 1) * ENTRY_SIZE];
+            let raw_move = u16::from_be_bytes([entry[8], entry[9]]);
+            let weight = u16::from_be_bytes([entry[10], entry[11]]);
+            if let Some(next_move) = decode_move(raw_move, &legal_moves) {
+                if best.is_none_or(|(best_weight, _)| weight > best_weight) {
+                    best = Some((weight, next_move));
+                }
+            }
+            first += 1;
+        }
+        best.map(|(_, next_move)| next_move)
+    }
+
+    fn key_at(&self, index: usize) -> u64 {
+        let entry = &self.map[index * ENTRY_SIZE..];
+        u64::from_be_bytes(entry[..8].try_into().expect("entry is 16 bytes"))
+    }
+}
+
+/// Decodes a Polyglot move against the legal moves of the position. The
+/// encoding packs destination file/row, origin file/row and a promotion
+/// index into the low 15 bits; castling is stored as "king takes own rook"
+/// (e.g. `e1h1`), which is matched against the engine's king-move encoding.
+fn decode_move(raw_move: u16, legal_moves: &[Move]) -> Option<Move> {
+    let square = |file_bits: u16, row_bits: u16| -> Option<Square> {
+        let file = File::try_from((file_bits & 7) as u8).ok()?;
+        let rank = Rank::try_from((row_bits & 7) as u8).ok()?;
+        Some(Square::new(file, rank))
+    };
+    let to = square(raw_move, raw_move >> 3)?;
+    let from = square(raw_move >> 6, raw_move >> 9)?;
+    let promotion = match (raw_move >> 12) & 7 {
+        0 => None,
+        1 => Some(Promotion::Knight),
+        2 => Some(Promotion::Bishop),
+        3 => Some(Promotion::Rook),
+        4 => Some(Promotion::Queen),
+        _ => return None,
+    };
+    let matches = |candidate: &&Move, to: Square| {
+        candidate.from_square() == from
+            && candidate.to_square() == to
+            && candidate.promotion() == promotion
+    };
+    if let Some(next_move) = legal_moves.iter().find(|candidate| matches(candidate, to)) {
+        return Some(*next_move);
+    }
+    // "King takes own rook" castling: translate the rook square into the
+    // king destination our move generator produces.
+    let castling_to = match (from, to) {
+        (Square::E1, Square::H1) => Square::G1,
+        (Square::E1, Square::A1) => Square::C1,
+        (Square::E8, Square::H8) => Square::G8,
+        (Square::E8, Square::A8) => Square::C8,
+        _ => return None,
+    };
+    legal_moves
+        .iter()
+        .find(|candidate| matches(candidate, castling_to))
+        .copied()
+}
@@ -1 +1,481 @@
-fn run() {}
+//! [Universal Chess Interface] front end. The protocol reader owns its
+//! thread (the process main thread) and never blocks on the search: `go`
+//! hands the position to a worker thread and returns to reading commands
+//! immediately, so `stop`, `ponderhit` and `isready` are answered mid-search
+//! within microseconds. Stopping is communicated to the search workers
+//! through an atomic flag they poll between simulations — tournament
+//! managers kill engines that stall on `stop`. Clock controls
+//! (`wtime`/`btime`/`winc`/`movestogo`/`movetime`) are translated into
+//! search deadlines by [`crate::search::time`].
+//!
+//! [Universal Chess Interface]: https://www.chessprogramming.org/UCI
+use std::io::{self, BufRead, Write};
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
+
+use crate::chess::core::Player;
+use crate::chess::position::{perft, Position};
+use crate::interface::book::Book;
+use crate::search::mcts::{Limits, Searcher};
+use crate::search::time::{self, Clock};
+
+/// Default size of the search tree arena in megabytes (the UCI `Hash`
+/// option).
+const DEFAULT_HASH_MB: usize = 64;
+/// Simulation budget of a `go` with no limits at all: no clock, no explicit
+/// `nodes`.
+const DEFAULT_NODE_BUDGET: usize = 100_000;
+/// Per-position simulation budget of the `bench` command.
+const BENCH_NODE_BUDGET: usize = 2000;
+/// Arena size `bench` searches with, independent of the configured `Hash`:
+/// the workload must be identical on every machine being compared.
+const BENCH_HASH_MB: usize = 16;
+
+/// Positions the `bench` command searches: every 5000th line of
+/// `data/positions.fen`, frozen here so that the workload is baked into the
+/// binary and identical across deployments. The slice covers openings,
+/// middlegames and endgames.
+const BENCH_POSITIONS: [&str; 20] = [
+    "5rk1/ppp4p/3r2p1/3P1n2/2PR4/3B4/P2Q2PP/5RK1 b - - 1 26",
+    "r2qk2r/3pbppp/p1p2n2/2p3B1/4N3/2Q2N2/PPP2PPP/R4RK1 w kq - 0 12",
+    "r2r1k2/3pbp1p/p3p1p1/8/B3N3/2P2P1n/P2K3P/R3R3 w - - 0 26",
+    "r2qk2r/p3bpp1/b1pp1n1p/2p1p3/4P3/2NP3P/PPP1QPP1/R1B1NRK1 b kq - 2 12",
+    "rnb1k2r/ppp2ppp/3b1q2/3pp3/4P3/2NP1N2/PPP2PPP/R2QKB1R b KQkq - 0 6",
+    "r1b2rk1/p1q1n1b1/1pn3pp/2p1pp2/8/3P1NPN/PPP2PBP/R1BQR1K1 b - - 5 15",
+    "r3k2r/1p1nn1pp/pq2p3/2p5/8/2N1QN2/PPP2PPP/R3K2R b KQkq - 3 13",
+    "rnbq1rk1/pp2ppbp/3p1np1/2p5/3P4/2PBPN2/PP1BQPPP/RN2K2R b KQ - 1 7",
+    "1r1q1r1k/1bp2p1p/p2p1N2/1p6/8/3P2Q1/PPP3PP/1RB2RK1 b - - 2 22",
+    "2r2rk1/pbq1bppp/1p2p3/3p4/1P6/P3PP2/2PQB1PP/2R1NRK1 b - - 0 16",
+    "1r1q1rk1/5ppp/1nb1pb2/p7/2PP4/Q1B1R3/1P1NBPPP/R5K1 b - - 8 23",
+    "r1N1kr2/pp5p/2n3p1/8/2B2B2/6P1/PPP2P1P/2KR3b b q - 0 18",
+    "r4rk1/pp2n1pp/2n5/2bppbN1/P6P/1P1P4/1BP2P2/R2QKB1R w KQ - 1 17",
+    "r2q1rk1/p2pbpp1/1p5p/3nP3/3P3Q/N7/PP3NPP/R4RK1 b - - 8 20",
+    "r7/pp3pkp/3p1bp1/3P4/6qP/5Q2/P3RPP1/6K1 w - - 1 24",
+    "r2k1b1r/p4pp1/nqpp1n1p/4p3/Bp2P3/1P1P1P1P/2P2P2/RNBQK2R w KQ - 1 14",
+    "8/2R1R1pk/8/4pp2/5r2/8/5K2/8 w - - 4 53",
+    "8/Qp4pk/B5bp/5p2/4pq2/1P6/R3K1P1/7r b - - 1 35",
+    "6k1/4R1pp/5p2/2b2n2/8/3K3P/1PP2PP1/8 w - - 0 35",
+    "rnbqk1nr/pppp1ppp/3b4/4p3/2P5/2N2P2/PP1PP1PP/R1BQKBNR b KQkq - 0 3",
+];
+
+/// Shared sink the reader and the search workers print responses to. Each
+/// line is written under the lock, so output from different threads can not
+/// interleave mid-line.
+type Output = Arc<Mutex<Box<dyn Write + Send>>>;
+
+/// Reads UCI commands from stdin until `quit` (or EOF) and responds on
+/// stdout.
+pub fn run() {
+    let mut engine = Engine::new(Box::new(io::stdout()));
+    let stdin = io::stdin();
+    for line in stdin.lock().lines() {
+        let Ok(line) = line else { break };
+        if !engine.execute(&line) {
+            break;
+        }
+    }
+    engine.stop_search();
+}
+
+/// UCI engine state: the game position, the searcher shared with the worker
+/// thread and the flags controlling it.
+pub struct Engine {
+    position: Position,
+    searcher: Arc<Mutex<Searcher>>,
+    /// Raised to terminate the current search; lowered before every `go`.
+    stop: Arc<AtomicBool>,
+    /// Raised while the current search is a ponder search: the worker holds
+    /// the `bestmove` back until `ponderhit` or `stop` arrives.
+    ponder: Arc<AtomicBool>,
+    /// Clock budget computed for a pending ponder search. A ponder search
+    /// runs on the opponent's time, so the budget is not armed until
+    /// `ponderhit` makes it our move.
+    ponder_deadlines: Option<time::Deadlines>,
+    /// Opening book (the `BookFile` option): positions found in it are
+    /// answered instantly without searching.
+    book: Option<Book>,
+    worker: Option<std::thread::JoinHandle<()>>,
+    output: Output,
+    threads: usize,
+}
+
+impl Engine {
+    /// Creates an engine writing its responses to `output`.
+    #[must_use]
+    pub fn new(output: Box<dyn Write + Send>) -> Self {
+        Self {
+            position: Position::starting(),
+            searcher: Arc::new(Mutex::new(Searcher::new(DEFAULT_HASH_MB))),
+            stop: Arc::new(AtomicBool::new(false)),
+            ponder: Arc::new(AtomicBool::new(false)),
+            ponder_deadlines: None,
+            book: None,
+            worker: None,
+            output: Arc::new(Mutex::new(output)),
+            threads: std::thread::available_parallelism().map_or(1, std::num::NonZeroUsize::get),
+        }
+    }
+
+    /// Executes one protocol line. Returns `false` when the engine should
+    /// shut down (`quit`).
+    pub fn execute(&mut self, line: &str) -> bool {
+        let mut tokens = line.split_whitespace();
+        match tokens.next() {
+            Some("uci") => {
+                self.send(&format!(
+                    "id name {} {}\nid author {}",
+                    env!("CARGO_PKG_NAME"),
+                    env!("CARGO_PKG_VERSION"),
+                    env!("CARGO_PKG_AUTHORS")
+                ));
+                self.send(&format!(
+                    "option name Hash type spin default {DEFAULT_HASH_MB} min 1 max 1048576"
+                ));
+                self.send(&format!(
+                    "option name Threads type spin default {} min 1 max 1024",
+                    self.threads
+                ));
+                self.send("option name Ponder type check default false");
+                self.send("option name BookFile type string default ");
+                self.send("uciok");
+            },
+            // The reader thread is never busy searching, so it can always
+            // answer immediately.
+            Some("isready") => self.send("readyok"),
+            Some("setoption") => self.set_option(line),
+            Some("ucinewgame") => {
+                self.stop_search();
+                self.position = Position::starting();
+                let mut searcher = self
+                    .searcher
+                    .lock()
+                    .expect("search worker does not poison the searcher");
+                *searcher = Searcher::new(DEFAULT_HASH_MB);
+            },
+            Some("position") => self.set_position(&mut tokens),
+            Some("go") => self.go(&mut tokens),
+            Some("bench") => self.bench(&mut tokens),
+            Some("stats") => self.send(crate::stats::report().trim_end()),
+            Some("stop") => self.stop_search(),
+            Some("ponderhit") => self.ponder_hit(),
+            Some("d") => self.send(&format!("{:?}", self.position)),
+            Some("quit") => {
+                self.stop_search();
+                return false;
+            },
+            Some(command) => self.send(&format!("info string unknown command: {command}")),
+            None => {},
+        }
+        true
+    }
+
+    /// Terminates the running search (if any) and waits for its `bestmove`
+    /// to be sent. The search threads poll the flag between simulations, so
+    /// this returns almost immediately.
+    pub fn stop_search(&mut self) {
+        self.stop.store(true, Ordering::Release);
+        self.ponder.store(false, Ordering::Release);
+        self.ponder_deadlines = None;
+        if let Some(worker) = self.worker.take() {
+            let _ = worker.join();
+        }
+    }
+
+    fn send(&self, response: &str) {
+        let mut output = self
+            .output
+            .lock()
+            .expect("output sink writers do not panic");
+        let _ = writeln!(output, "{response}");
+        let _ = output.flush();
+    }
+
+    fn set_option(&mut self, line: &str) {
+        // `setoption name <id> value <x>`: the name can contain spaces, but
+        // none of ours do.
+        let mut tokens = line.split_whitespace().skip(1);
+        let (name, value) = match (tokens.next(), tokens.next(), tokens.next(), tokens.next()) {
+            (Some("name"), Some(name), Some("value"), Some(value)) => (name, value),
+            _ => {
+                self.send("info string malformed setoption");
+                return;
+            },
+        };
+        match (name, value.parse::<usize>()) {
+            ("Threads", Ok(threads)) => self.threads = threads.clamp(1, 1024),
+            ("Hash", Ok(megabytes)) => {
+                self.stop_search();
+                let mut searcher = self
+                    .searcher
+                    .lock()
+                    .expect("search worker does not poison the searcher");
+                *searcher = Searcher::new(megabytes.clamp(1, 1_048_576));
+            },
+            ("Ponder", _) => {},
+            ("BookFile", _) => match Book::open(value) {
+                Ok(book) => self.book = Some(book),
+                Err(e) => self.send(&format!("info string can not load book: {e:#}")),
+            },
+            _ => self.send(&format!("info string unsupported option: {name}")),
+        }
+    }
+
+    fn set_position<'a>(&mut self, tokens: &mut impl Iterator<Item = &'a str>) {
+        let mut position = match tokens.next() {
+            Some("startpos") => Position::starting(),
+            Some("fen") => {
+                let fen: Vec<&str> = tokens
+                    .by_ref()
+                    .take_while(|token| *token != "moves")
+                    .collect();
+                match Position::from_fen(&fen.join(" ")) {
+                    Ok(position) => position,
+                    Err(e) => {
+                        self.send(&format!("info string invalid position: {e:#}"));
+                        return;
+                    },
+                }
+            },
+            _ => {
+                self.send("info string malformed position command");
+                return;
+            },
+        };
+        for token in tokens.by_ref() {
+            if token == "moves" {
+                continue;
+            }
+            // Moves arrive in UCI long algebraic notation: match against the
+            // legal moves of the current position.
+            match position
+                .generate_moves()
+                .iter()
+                .find(|next_move| next_move.to_string() == token)
+            {
+                Some(next_move) => {
+                    let next_move = *next_move;
+                    position.make_move(&next_move);
+                },
+                None => {
+                    self.send(&format!("info string illegal move: {token}"));
+                    return;
+                },
+            }
+        }
+        self.position = position;
+    }
+
+    fn go<'a>(&mut self, tokens: &mut impl Iterator<Item = &'a str>) {
+        self.stop_search();
+        let mut node_budget = None;
+        let mut infinite = false;
+        let mut pondering = false;
+        let mut movetime = None;
+        // Clock state for [white, black]: only our side of it matters, but
+        // the side to move is not known until the tokens are consumed.
+        let mut time_left = [None, None];
+        let mut increment = [Duration::ZERO; 2];
+        let mut moves_to_go = None;
+        while let Some(token) = tokens.next() {
+            match token {
+                "perft" => {
+                    let depth = tokens
+                        .next()
+                        .and_then(|value| value.parse().ok())
+                        .unwrap_or(1);
+                    self.perft_divide(depth);
+                    return;
+                },
+                "nodes" => node_budget = tokens.next().and_then(|value| value.parse().ok()),
+                "infinite" => infinite = true,
+                "ponder" => pondering = true,
+                "wtime" => time_left[0] = parse_millis(tokens.next()),
+                "btime" => time_left[1] = parse_millis(tokens.next()),
+                "winc" => increment[0] = parse_millis(tokens.next()).unwrap_or(Duration::ZERO),
+                "binc" => increment[1] = parse_millis(tokens.next()).unwrap_or(Duration::ZERO),
+                "movestogo" => moves_to_go = tokens.next().and_then(|value| value.parse().ok()),
+                "movetime" => movetime = parse_millis(tokens.next()),
+                // The search is not depth-limited: a node budget bounds it
+                // the same way.
+                "depth" => {
+                    let _ = tokens.next();
+                },
+                _ => {},
+            }
+        }
+        // A book hit answers instantly, with no search to stop or ponder.
+        if !infinite && !pondering {
+            if let Some(next_move) = self
+                .book
+                .as_ref()
+                .and_then(|book| book.probe(&self.position))
+            {
+                self.send(&format!("bestmove {next_move}"));
+                return;
+            }
+        }
+        let us = match self.position.side_to_move() {
+            Player::White => 0,
+            Player::Black => 1,
+        };
+        let deadlines = match movetime {
+            Some(movetime) => Some(time::Deadlines::fixed(movetime)),
+            None => time_left[us].map(|remaining| {
+                time::schedule(&Clock {
+                    time_left: remaining,
+                    increment: increment[us],
+                    moves_to_go,
+                })
+            }),
+        };
+        // An explicit node budget is respected as given; a clock makes the
+        // budget unbounded and lets the deadlines cut the search instead.
+        let nodes = node_budget.unwrap_or(if infinite || pondering || deadlines.is_some() {
+            usize::MAX
+        } else {
+            DEFAULT_NODE_BUDGET
+        });
+        let mut limits = Limits::nodes(nodes);
+        // `go infinite` thinks until `stop` no matter what the clock says; a
+        // ponder search runs on the opponent's time and only starts spending
+        // its own budget at `ponderhit`.
+        if !infinite && !pondering {
+            if let Some(deadlines) = deadlines {
+                let now = Instant::now();
+                limits.soft_deadline = Some(now + deadlines.soft);
+                limits.hard_deadline = Some(now + deadlines.hard);
+            }
+        }
+        self.ponder_deadlines = if pondering { deadlines } else { None };
+        // A no-op unless the binary was built with the `stats` feature: the
+        // counters cover exactly one search.
+        crate::stats::reset();
+        // A fresh stop flag for every search: a stale ponder watchdog firing
+        // late can only raise the flag of the search it was armed for.
+        self.stop = Arc::new(AtomicBool::new(false));
+        self.ponder.store(pondering, Ordering::Release);
+        let searcher = Arc::clone(&self.searcher);
+        let stop = Arc::clone(&self.stop);
+        let ponder = Arc::clone(&self.ponder);
+        let output = Arc::clone(&self.output);
+        let position = self.position.clone();
+        let threads = self.threads;
+        self.worker = Some(std::thread::spawn(move || {
+            let mut searcher = searcher
+                .lock()
+                .expect("search worker does not poison the searcher");
+            let best = searcher.search(&position, &limits, threads, &stop);
+            let reply = best.and_then(|best| searcher.best_reply(&best));
+            drop(searcher);
+            // A finished ponder search holds its answer back until the GUI
+            // resolves it with `ponderhit` or `stop`.
+            while ponder.load(Ordering::Acquire) && !stop.load(Ordering::Acquire) {
+                std::thread::sleep(Duration::from_millis(1));
+            }
+            let response = match (best, reply) {
+                // Suggest pondering on the predicted reply: the opponent's
+                // clock time becomes our compute time.
+                (Some(best), Some(reply)) => format!("bestmove {best} ponder {reply}"),
+                (Some(best), None) => format!("bestmove {best}"),
+                // The all-zero move is the protocol's "no move possible".
+                (None, _) => "bestmove 0000".to_string(),
+            };
+            let mut output = output.lock().expect("output sink writers do not panic");
+            if cfg!(feature = "stats") {
+                for line in crate::stats::report().lines() {
+                    let _ = writeln!(output, "info string {line}");
+                }
+            }
+            let _ = writeln!(output, "{response}");
+            let _ = output.flush();
+        }));
+    }
+
+    /// Runs `go perft <depth>` in the "divide" format reference engines use:
+    /// one `<move>: <nodes>` line per root move followed by the total. This
+    /// is how move generation regressions are bisected against reference
+    /// counts. Runs on the worker thread so the reader stays responsive, but
+    /// is not interruptible: a started perft runs to completion.
+    fn perft_divide(&mut self, depth: u8) {
+        let output = Arc::clone(&self.output);
+        let position = self.position.clone();
+        self.worker = Some(std::thread::spawn(move || {
+            let mut total = 0;
+            let mut report = String::new();
+            for next_move in position.generate_moves().iter() {
+                let mut child = position.clone();
+                child.make_move(next_move);
+                let nodes = if depth > 1 {
+                    perft(&child, depth - 1)
+                } else {
+                    1
+                };
+                total += nodes;
+                report.push_str(&format!("{next_move}: {nodes}\n"));
+            }
+            report.push_str(&format!("\nNodes searched: {total}"));
+            let mut output = output.lock().expect("output sink writers do not panic");
+            let _ = writeln!(output, "{report}");
+            let _ = output.flush();
+        }));
+    }
+
+    /// Runs the fixed `bench` workload: every position in
+    /// [`BENCH_POSITIONS`] is searched to a fixed simulation budget on one
+    /// thread, and the totals, wall time, throughput and a signature folded
+    /// from the chosen moves are reported. Deployments are validated by
+    /// comparing the signature (which is fixed by construction: the
+    /// single-threaded search is deterministic) and the NPS across machines.
+    /// An optional argument overrides the per-position budget: `bench 50000`.
+    /// Runs synchronously — `bench` is an offline validation command, not a
+    /// GUI one.
+    fn bench<'a>(&mut self, tokens: &mut impl Iterator<Item = &'a str>) {
+        self.stop_search();
+        let budget = tokens
+            .next()
+            .and_then(|value| value.parse().ok())
+            .unwrap_or(BENCH_NODE_BUDGET);
+        let limits = Limits::nodes(budget);
+        let stop = AtomicBool::new(false);
+        // A dedicated searcher, so the workload does not depend on the
+        // configured options or the state of the game tree.
+        let mut searcher = Searcher::new(BENCH_HASH_MB);
+        let mut signature = 0u64;
+        let start = Instant::now();
+        for fen in BENCH_POSITIONS {
+            let position = Position::from_fen(fen).expect("bench positions are valid");
+            let best = searcher.search(&position, &limits, 1, &stop);
+            signature = signature.rotate_left(7) ^ u64::from(best.map_or(0, |best| best.bits()));
+        }
+        let elapsed = start.elapsed();
+        let nodes = (budget * BENCH_POSITIONS.len()) as u64;
+        self.send(&format!(
+            "Total nodes:  {nodes}\nTotal time:   {} ms\nNodes/second: {}\nSignature:    {signature:016x}",
+            elapsed.as_millis(),
+            nodes * 1000 / (elapsed.as_millis().max(1) as u64),
+        ));
+    }
+
+    /// Converts the running ponder search into a live one: releases the held
+    /// `bestmove` and arms the clock budget computed at `go` time. Only the
+    /// hard deadline is enforced from here — the tree already holds the
+    /// ponder work, so the soft-deadline extension logic has little to add.
+    fn ponder_hit(&mut self) {
+        self.ponder.store(false, Ordering::Release);
+        if let Some(deadlines) = self.ponder_deadlines.take() {
+            let stop = Arc::clone(&self.stop);
+            let _ = std::thread::spawn(move || {
+                std::thread::sleep(deadlines.hard);
+                stop.store(true, Ordering::Release);
+            });
+        }
+    }
+}
+
+/// Parses a clock token value: the protocol reports milliseconds, and some
+/// GUIs send negative values once a flag has fallen.
+fn parse_millis(token: Option<&str>) -> Option<Duration> {
+    let millis: i64 = token?.parse().ok()?;
+    Some(Duration::from_millis(millis.max(0) as u64))
+}
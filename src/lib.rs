@@ -49,6 +49,9 @@
 pub mod chess;
 pub mod evaluation;
 pub mod interface;
+pub mod search;
+pub mod stats;
+pub mod training;
 
 pub mod util;
 
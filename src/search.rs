@@ -0,0 +1,8 @@
+//! Search for the best move in a given position: the "brain" of the engine.
+//! Hosts the shared infrastructure (e.g. the transposition table) used by the
+//! search algorithms.
+
+pub mod mcts;
+pub mod syzygy;
+pub mod time;
+pub mod transposition;
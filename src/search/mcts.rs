@@ -0,0 +1,639 @@
+//! [Monte-Carlo Tree Search] driving the engine: the tree policy is [PUCT]
+//! (as popularized by AlphaZero) and the whole tree is shared between search
+//! threads without any locks. Threads descend concurrently, each on its own
+//! clone of the root [`Position`]: statistics are plain atomic counters,
+//! expansion is guarded by a single compare-and-swap on the node state and
+//! [virtual loss] keeps the threads from piling onto the same line. This is
+//! what makes the search scale on many-core hardware, which is the primary
+//! deployment target.
+//!
+//! The tree lives in a fixed-capacity [`Arena`]: nodes are referred to by
+//! `u32` indices instead of pointers (halving the footprint of child links)
+//! and handed out by bumping an atomic cursor, so expansion does not touch
+//! the general-purpose allocator. The tree is bounded by a fixed node
+//! budget, so runs with the same budget and a single thread are fully
+//! reproducible, which is important for strength testing.
+//!
+//! [Monte-Carlo Tree Search]: https://www.chessprogramming.org/Monte-Carlo_Tree_Search
+//! [PUCT]: https://www.chessprogramming.org/UCT
+//! [virtual loss]: https://www.chessprogramming.org/MCTS#Parallelization
+use std::sync::atomic::{AtomicBool, AtomicI64, AtomicU16, AtomicU32, AtomicU8, AtomicUsize, Ordering};
+use std::sync::Arc;
+use std::time::Instant;
+
+use crate::chess::core::{Move, PieceKind};
+use crate::chess::position::{GameStatus, Position};
+use crate::search::syzygy::{Tablebases, Wdl};
+
+/// Exploration constant of the PUCT formula: higher values spread the visits
+/// wider, lower ones concentrate them on the current best line.
+const EXPLORATION: f32 = 1.4;
+
+/// Values are accumulated in fixed point: atomics do not support
+/// floating-point addition and a CAS loop on every backup would defeat the
+/// purpose of the lock-free design. One value unit is 1/256th of a win.
+const VALUE_SCALE: i64 = 256;
+
+/// How many simulations a search thread runs between checks of the wall
+/// clock: checking every simulation would waste time on `Instant::now`,
+/// checking every few hundred keeps the deadline overshoot well under a
+/// millisecond of work per thread.
+const DEADLINE_POLL_INTERVAL: usize = 128;
+
+/// Limits of one search. The node budget bounds the tree; the optional
+/// deadlines bound the wall clock (computed by [`crate::search::time`] from
+/// the game clock). The hard deadline is absolute. The soft deadline is the
+/// target spend: the search is cut there once the root visit distribution
+/// has settled on a move, and runs on towards the hard deadline while the
+/// top candidates are still contested — unstable positions get extra time,
+/// decided ones give it back.
+pub struct Limits {
+    /// Maximum number of simulations to run.
+    pub nodes: usize,
+    /// Target point to stop at once the best move has converged.
+    pub soft_deadline: Option<Instant>,
+    /// Point at which the search stops unconditionally.
+    pub hard_deadline: Option<Instant>,
+}
+
+impl Limits {
+    /// Limits the search by the simulation count alone.
+    #[must_use]
+    pub fn nodes(nodes: usize) -> Self {
+        Self {
+            nodes,
+            soft_deadline: None,
+            hard_deadline: None,
+        }
+    }
+}
+
+/// Expansion states of a node, stored in [`Node::state`].
+const NEW: u8 = 0;
+/// Some thread won the expansion race and is generating the children. Other
+/// threads treat the node as a leaf until the children are published.
+const EXPANDING: u8 = 1;
+/// Children are published; a `READY` node always has at least one.
+const READY: u8 = 2;
+/// The node could not be expanded because the tree ran out of memory. It is
+/// evaluated as a leaf until the arena is compacted by
+/// [`Searcher::advance`].
+const EXHAUSTED: u8 = 3;
+/// The position is over and lost for the side to move (checkmate). Terminal
+/// states are settled once by [`Position::game_status_with_moves`] during
+/// expansion; revisits read the verdict off the node instead of re-deriving
+/// it from the board.
+const TERMINAL_LOSS: u8 = 4;
+/// The position is over and drawn: stalemate, fifty-move rule or
+/// insufficient material.
+const TERMINAL_DRAW: u8 = 5;
+
+/// A single tree node, reached by a unique sequence of moves from the root.
+/// All mutable statistics are atomics so that any number of threads can
+/// select through and back up into the node concurrently. Padded to 32 bytes
+/// so that a cache line holds a whole number of nodes.
+#[derive(Default)]
+#[repr(align(32))]
+struct Node {
+    /// Number of simulations that went through this node, including the
+    /// in-flight ones (virtual loss pre-increments the counter on the way
+    /// down).
+    visits: AtomicU32,
+    /// Sum of backed-up values scaled by [`VALUE_SCALE`], from the
+    /// perspective of the player who moved *into* this node (i.e. the side
+    /// to move at the parent). This is the AlphaZero `W(s, a)` convention:
+    /// the parent maximizes `Q` over its children directly.
+    value_sum: AtomicI64,
+    /// Index of the first child in the node arena. Children of one node form
+    /// a contiguous block starting on a cache-line boundary.
+    first_child: AtomicU32,
+    /// Number of children: the number of legal moves at this node.
+    num_children: AtomicU16,
+    /// One of [`NEW`], [`EXPANDING`], [`READY`], [`EXHAUSTED`].
+    state: AtomicU8,
+    /// The packed [`Move`] leading from the parent to this node. Written once
+    /// during expansion, before the parent is marked [`READY`].
+    next_move: AtomicU16,
+}
+
+impl Node {
+    fn reset(&self) {
+        self.visits.store(0, Ordering::Relaxed);
+        self.value_sum.store(0, Ordering::Relaxed);
+        self.first_child.store(0, Ordering::Relaxed);
+        self.num_children.store(0, Ordering::Relaxed);
+        self.state.store(NEW, Ordering::Relaxed);
+        self.next_move.store(0, Ordering::Relaxed);
+    }
+}
+
+/// Number of nodes per 64-byte cache line.
+const NODES_PER_BLOCK: usize = 64 / size_of::<Node>();
+
+/// A cache-line-sized, cache-line-aligned block of nodes: the allocation
+/// granule of the arena. Sibling batches start on a block boundary, so the
+/// hot PUCT loop over the children of one node streams through aligned lines
+/// and never splits a node across two of them.
+#[derive(Default)]
+#[repr(align(64))]
+struct Block {
+    nodes: [Node; NODES_PER_BLOCK],
+}
+
+/// Fixed-capacity slab the search tree lives in. Expansion batches are
+/// carved out by bumping `allocated`: no locks, no per-node allocations, no
+/// fragmentation over long games. Reclamation is wholesale — either the
+/// whole tree is dropped or the subtree of the played move is compacted to
+/// the front by [`Searcher::advance`] — so there is no free list to
+/// maintain or walk.
+struct Arena {
+    blocks: Box<[Block]>,
+    /// Bump cursor in nodes; always a multiple of [`NODES_PER_BLOCK`].
+    /// Everything below it is in use by the current tree.
+    allocated: AtomicUsize,
+}
+
+impl Arena {
+    fn new(size_mb: usize) -> Self {
+        let blocks = (size_mb * 1024 * 1024 / size_of::<Block>()).max(1);
+        Self {
+            blocks: std::iter::repeat_with(Block::default).take(blocks).collect(),
+            allocated: AtomicUsize::new(NODES_PER_BLOCK),
+        }
+    }
+
+    fn node(&self, index: u32) -> &Node {
+        &self.blocks[index as usize / NODES_PER_BLOCK].nodes[index as usize % NODES_PER_BLOCK]
+    }
+
+    fn capacity(&self) -> usize {
+        self.blocks.len() * NODES_PER_BLOCK
+    }
+
+    /// Hands out a batch of `count` fresh nodes starting on a block
+    /// boundary, or `None` when the arena is out of capacity.
+    fn allocate(&self, count: usize) -> Option<u32> {
+        let nodes = count.next_multiple_of(NODES_PER_BLOCK);
+        let first = self.allocated.fetch_add(nodes, Ordering::Relaxed);
+        if first + nodes > self.capacity() {
+            return None;
+        }
+        Some(first as u32)
+    }
+
+    /// Resets the used prefix of the arena, leaving a fresh root. The
+    /// untouched tail is already clean.
+    fn clear(&mut self) {
+        let used = self.allocated.load(Ordering::Relaxed).min(self.capacity());
+        for index in 0..used {
+            self.node(index as u32).reset();
+        }
+        self.allocated.store(NODES_PER_BLOCK, Ordering::Relaxed);
+    }
+}
+
+/// Plain (non-atomic) copy of a node, used while compacting a retained
+/// subtree to the front of the arena.
+#[derive(Clone, Default)]
+struct Snapshot {
+    visits: u32,
+    value_sum: i64,
+    first_child: u32,
+    num_children: u16,
+    state: u8,
+    next_move: u16,
+}
+
+/// MCTS searcher owning the tree arena. The arena is sized once (like the
+/// transposition table) and reused for the whole game: successive searches
+/// of the same position accumulate statistics, and [`Searcher::advance`]
+/// recycles the relevant subtree when a move is played.
+pub struct Searcher {
+    arena: Arena,
+    /// Hash of the position the tree root corresponds to; `None` while the
+    /// tree is empty. A search of any other position drops the tree.
+    root_hash: Option<u64>,
+    /// Endgame tablebases consulted at leaf evaluation: a probe replaces the
+    /// whole subtree below the leaf with the proven game value.
+    tablebases: Option<Arc<Tablebases>>,
+}
+
+impl Searcher {
+    /// Creates a searcher with a node arena occupying roughly `size_mb`
+    /// megabytes.
+    #[must_use]
+    pub fn new(size_mb: usize) -> Self {
+        Self {
+            arena: Arena::new(size_mb),
+            root_hash: None,
+            tablebases: None,
+        }
+    }
+
+    /// Attaches (or detaches, with `None`) endgame tablebases. Leaves inside
+    /// tablebase territory are then scored by probing instead of the static
+    /// evaluation.
+    pub fn set_tablebases(&mut self, tablebases: Option<Arc<Tablebases>>) {
+        self.tablebases = tablebases;
+    }
+
+    /// Searches the position until the [`Limits`] are exhausted or `stop` is
+    /// raised, and returns the most visited root move. Returns `None` when
+    /// there are no legal moves (the game is over) or the tree has no visits
+    /// at all.
+    ///
+    /// The `stop` flag is polled between simulations, so an external request
+    /// (e.g. UCI `stop`) terminates the search within microseconds.
+    /// `threads` search threads descend the shared tree in parallel; with
+    /// `threads == 1`, an untouched `stop` and no deadlines the result is
+    /// deterministic for a given budget.
+    pub fn search(
+        &mut self,
+        position: &Position,
+        limits: &Limits,
+        threads: usize,
+        stop: &AtomicBool,
+    ) -> Option<Move> {
+        if self.root_hash != Some(position.hash()) {
+            self.arena.clear();
+            self.root_hash = Some(position.hash());
+        }
+        let simulations = AtomicUsize::new(0);
+        std::thread::scope(|scope| {
+            for _ in 0..threads.max(1) {
+                let _ = scope.spawn(|| {
+                    // Each thread replays moves on its own copy of the root
+                    // position: the tree stores only statistics and moves.
+                    let mut position = position.clone();
+                    let mut path = Vec::with_capacity(64);
+                    let mut since_poll = 0;
+                    while !stop.load(Ordering::Relaxed)
+                        && simulations.fetch_add(1, Ordering::Relaxed) < limits.nodes
+                    {
+                        self.simulate(&mut position, &mut path);
+                        since_poll += 1;
+                        if since_poll == DEADLINE_POLL_INTERVAL {
+                            since_poll = 0;
+                            self.check_deadlines(limits, stop);
+                        }
+                    }
+                    // Publish this worker's statistics before the scope
+                    // unblocks: the TLS destructor would fold them too late
+                    // for a report printed right after the search.
+                    crate::stats::flush();
+                });
+            }
+        });
+        self.best_root_move()
+    }
+
+    /// Raises `stop` when a wall-clock limit is exceeded: unconditionally
+    /// past the hard deadline, and past the soft one once the root choice has
+    /// converged. Polled by every search thread, so the other threads pick
+    /// the flag up on their next simulation.
+    fn check_deadlines(&self, limits: &Limits, stop: &AtomicBool) {
+        let now = Instant::now();
+        let past = |deadline: Option<Instant>| deadline.is_some_and(|deadline| now >= deadline);
+        if past(limits.hard_deadline) || (past(limits.soft_deadline) && self.root_converged()) {
+            stop.store(true, Ordering::Relaxed);
+        }
+    }
+
+    /// Whether more simulations are unlikely to change the root choice: the
+    /// most visited root move leads the runner-up by a comfortable margin.
+    /// Visits are a slowly-moving statistic, so a lead of a third takes at
+    /// least as many simulations again to overturn.
+    fn root_converged(&self) -> bool {
+        let root = self.arena.node(0);
+        if root.state.load(Ordering::Acquire) != READY {
+            return false;
+        }
+        let first_child = root.first_child.load(Ordering::Relaxed);
+        let num_children = u32::from(root.num_children.load(Ordering::Relaxed));
+        let (mut best, mut second) = (0, 0);
+        for index in first_child..first_child + num_children {
+            let visits = self.arena.node(index).visits.load(Ordering::Relaxed);
+            if visits > best {
+                (best, second) = (visits, best);
+            } else if visits > second {
+                second = visits;
+            }
+        }
+        best > second + second / 3
+    }
+
+    /// Tells the searcher that `next_move` was played in `position` (which
+    /// must be the position the tree was built for). The subtree of the
+    /// played move survives as the new tree — its statistics seed the next
+    /// search — and the rest of the arena is reclaimed by compacting the
+    /// subtree to the front, without walking any free list.
+    pub fn advance(&mut self, position: &Position, next_move: &Move) {
+        let mut next_position = position.clone();
+        next_position.make_move(next_move);
+        let next_hash = next_position.hash();
+        let retained = self.find_root_child(position, next_move);
+        match retained {
+            Some(child) => self.retain_subtree(child),
+            None => self.arena.clear(),
+        }
+        self.root_hash = Some(next_hash);
+    }
+
+    fn find_root_child(&self, position: &Position, next_move: &Move) -> Option<u32> {
+        if self.root_hash != Some(position.hash()) {
+            return None;
+        }
+        self.child_by_move(0, next_move)
+    }
+
+    /// Finds the child of `parent` reached by `next_move`, or `None` when the
+    /// parent has no published children.
+    fn child_by_move(&self, parent: u32, next_move: &Move) -> Option<u32> {
+        let node = self.arena.node(parent);
+        if node.state.load(Ordering::Acquire) != READY {
+            return None;
+        }
+        let first_child = node.first_child.load(Ordering::Relaxed);
+        let num_children = u32::from(node.num_children.load(Ordering::Relaxed));
+        (first_child..first_child + num_children).find(|&index| {
+            self.arena.node(index).next_move.load(Ordering::Relaxed) == next_move.bits()
+        })
+    }
+
+    /// Compacts the subtree rooted at `subtree_root` to the front of the
+    /// arena, making it the new tree. Runs on `&mut self`, i.e. with no
+    /// concurrent search: the nodes can be read and rewritten non-atomically.
+    fn retain_subtree(&mut self, subtree_root: u32) {
+        let mut scratch: Vec<Snapshot> = vec![Snapshot::default(); NODES_PER_BLOCK];
+        let mut queue = vec![(subtree_root, 0u32)];
+        while let Some((old_index, new_index)) = queue.pop() {
+            let node = self.arena.node(old_index);
+            let mut snapshot = Snapshot {
+                visits: node.visits.load(Ordering::Relaxed),
+                value_sum: node.value_sum.load(Ordering::Relaxed),
+                first_child: 0,
+                num_children: node.num_children.load(Ordering::Relaxed),
+                state: node.state.load(Ordering::Relaxed),
+                next_move: node.next_move.load(Ordering::Relaxed),
+            };
+            // Nodes starved by a full arena get another chance once the
+            // compaction frees up space.
+            if snapshot.state == EXHAUSTED {
+                snapshot.state = NEW;
+            }
+            if snapshot.state == READY && snapshot.num_children > 0 {
+                let old_first = node.first_child.load(Ordering::Relaxed);
+                let new_first = scratch.len() as u32;
+                // The batch sizing mirrors Arena::allocate, so the compacted
+                // tree can not outgrow the original one.
+                scratch.resize(
+                    scratch.len()
+                        + (snapshot.num_children as usize).next_multiple_of(NODES_PER_BLOCK),
+                    Snapshot::default(),
+                );
+                snapshot.first_child = new_first;
+                for child in 0..u32::from(snapshot.num_children) {
+                    queue.push((old_first + child, new_first + child));
+                }
+            }
+            scratch[new_index as usize] = snapshot;
+        }
+        let used = self
+            .arena
+            .allocated
+            .load(Ordering::Relaxed)
+            .min(self.arena.capacity());
+        for (index, snapshot) in scratch.iter().enumerate() {
+            let node = self.arena.node(index as u32);
+            node.visits.store(snapshot.visits, Ordering::Relaxed);
+            node.value_sum.store(snapshot.value_sum, Ordering::Relaxed);
+            node.first_child.store(snapshot.first_child, Ordering::Relaxed);
+            node.num_children.store(snapshot.num_children, Ordering::Relaxed);
+            node.state.store(snapshot.state, Ordering::Relaxed);
+            node.next_move.store(snapshot.next_move, Ordering::Relaxed);
+        }
+        for index in scratch.len()..used {
+            self.arena.node(index as u32).reset();
+        }
+        self.arena.allocated.store(scratch.len(), Ordering::Relaxed);
+    }
+
+    /// Runs one simulation: descends from the root following PUCT, expands
+    /// the reached leaf, evaluates it and backs the value up along the path.
+    /// `position` must be at the root and is restored before returning.
+    fn simulate(&self, position: &mut Position, path: &mut Vec<u32>) {
+        crate::stats::record(crate::stats::Event::Simulations, 1);
+        path.clear();
+        let mut index = 0u32;
+        let leaf_value = loop {
+            let node = self.arena.node(index);
+            path.push(index);
+            // Virtual loss: an in-flight simulation looks like a lost one, so
+            // concurrent threads are biased away from this exact line until
+            // the backup corrects the statistics.
+            let _ = node.visits.fetch_add(1, Ordering::Relaxed);
+            let _ = node.value_sum.fetch_sub(VALUE_SCALE, Ordering::Relaxed);
+            // The tree has no transpositions (each node is reached by one
+            // path), so path-dependent draws can be settled per node.
+            if path.len() > 1 && position.is_threefold_repetition() {
+                break 0.0;
+            }
+            match node
+                .state
+                .compare_exchange(NEW, EXPANDING, Ordering::Acquire, Ordering::Acquire)
+            {
+                Ok(_) => break self.expand(node, position),
+                Err(TERMINAL_LOSS) => break -1.0,
+                Err(TERMINAL_DRAW) => break 0.0,
+                Err(READY) => {
+                    let num_children = node.num_children.load(Ordering::Relaxed);
+                    index = self.select_child(node, num_children);
+                    let next_move =
+                        Move::from_bits(self.arena.node(index).next_move.load(Ordering::Relaxed));
+                    position.make_move(&next_move);
+                },
+                // Another thread is publishing the children or the arena is
+                // full: evaluate the node as a leaf instead of waiting.
+                Err(_) => break self.leaf_value(position),
+            }
+        };
+        // Back the value up, undoing the virtual loss. The leaf value is from
+        // the perspective of the side to move at the leaf; each node stores
+        // values from its parent's perspective, so the sign flips at every
+        // step (including the first one).
+        let mut value = leaf_value;
+        for &index in path.iter().rev() {
+            value = -value;
+            let correction = VALUE_SCALE + (value * VALUE_SCALE as f32) as i64;
+            let _ = self
+                .arena
+                .node(index)
+                .value_sum
+                .fetch_add(correction, Ordering::Relaxed);
+        }
+        for _ in 1..path.len() {
+            position.unmake_move();
+        }
+    }
+
+    /// Publishes the children of `node` (the expansion CAS was already won by
+    /// the caller) and returns the leaf evaluation of `position`. Terminal
+    /// positions are settled here in a single fused pass over the move list
+    /// and the cached draw state, and marked so that revisits are free.
+    fn expand(&self, node: &Node, position: &Position) -> f32 {
+        let moves = position.generate_moves();
+        match position.game_status_with_moves(&moves) {
+            GameStatus::Ongoing => {},
+            GameStatus::Checkmate => {
+                node.state.store(TERMINAL_LOSS, Ordering::Release);
+                return -1.0;
+            },
+            _ => {
+                node.state.store(TERMINAL_DRAW, Ordering::Release);
+                return 0.0;
+            },
+        }
+        match self.arena.allocate(moves.len()) {
+            Some(first_child) => {
+                for (child, next_move) in moves.iter().enumerate() {
+                    self.arena
+                        .node(first_child + child as u32)
+                        .next_move
+                        .store(next_move.bits(), Ordering::Relaxed);
+                }
+                node.first_child.store(first_child, Ordering::Relaxed);
+                node.num_children
+                    .store(moves.len() as u16, Ordering::Relaxed);
+                // Publish: the Release store pairs with the Acquire failure
+                // of the expansion CAS in selecting threads.
+                node.state.store(READY, Ordering::Release);
+            },
+            None => node.state.store(EXHAUSTED, Ordering::Release),
+        }
+        self.leaf_value(position)
+    }
+
+    /// Scores a leaf: by a tablebase probe when the position is inside
+    /// tablebase territory (the probe is the exact game value, so the whole
+    /// subtree below the leaf collapses into one lookup), by the static
+    /// evaluation otherwise. Cursed wins and blessed losses count as draws —
+    /// that is what they are over the board.
+    fn leaf_value(&self, position: &Position) -> f32 {
+        if let Some(wdl) = self
+            .tablebases
+            .as_ref()
+            .and_then(|tablebases| tablebases.probe_wdl(position))
+        {
+            return match wdl {
+                Wdl::Win => 1.0,
+                Wdl::Loss => -1.0,
+                Wdl::Draw | Wdl::CursedWin | Wdl::BlessedLoss => 0.0,
+            };
+        }
+        evaluate(position)
+    }
+
+    /// Picks the child of `node` maximizing the PUCT score
+    /// `Q + c * P * sqrt(N) / (1 + n)`. There is no policy network yet, so
+    /// the prior `P` is uniform over the children.
+    fn select_child(&self, node: &Node, num_children: u16) -> u32 {
+        let first_child = node.first_child.load(Ordering::Relaxed);
+        let parent_visits = node.visits.load(Ordering::Relaxed);
+        let exploration_scale =
+            EXPLORATION * (parent_visits as f32).sqrt() / f32::from(num_children);
+        let mut best_index = first_child;
+        let mut best_score = f32::NEG_INFINITY;
+        for index in first_child..first_child + u32::from(num_children) {
+            let child = self.arena.node(index);
+            let visits = child.visits.load(Ordering::Relaxed);
+            let exploitation = if visits == 0 {
+                0.0
+            } else {
+                child.value_sum.load(Ordering::Relaxed) as f32
+                    / (i64::from(visits) * VALUE_SCALE) as f32
+            };
+            let score = exploitation + exploration_scale / (1 + visits) as f32;
+            if score > best_score {
+                best_score = score;
+                best_index = index;
+            }
+        }
+        best_index
+    }
+
+    fn best_root_move(&self) -> Option<Move> {
+        let child = self.most_visited_child(0)?;
+        Some(Move::from_bits(
+            self.arena.node(child).next_move.load(Ordering::Relaxed),
+        ))
+    }
+
+    /// Returns the predicted reply to `next_move`: the most visited child of
+    /// the corresponding root child. The UCI front end suggests it as the
+    /// ponder move, so the opponent's thinking time is spent searching the
+    /// line the tree already considers most likely.
+    #[must_use]
+    pub fn best_reply(&self, next_move: &Move) -> Option<Move> {
+        let child = self.child_by_move(0, next_move)?;
+        let reply = self.arena.node(self.most_visited_child(child)?);
+        // An unvisited reply carries no information: better no hint than an
+        // arbitrary one.
+        if reply.visits.load(Ordering::Relaxed) == 0 {
+            return None;
+        }
+        Some(Move::from_bits(reply.next_move.load(Ordering::Relaxed)))
+    }
+
+    /// Returns the visit count of every root move: the raw visit
+    /// distribution that [`Searcher::best_root_move`] maximizes over. In
+    /// self-play data generation this is the policy target the network is
+    /// trained towards. Empty when the root has no published children.
+    #[must_use]
+    pub fn root_visits(&self) -> Vec<(Move, u32)> {
+        let root = self.arena.node(0);
+        if root.state.load(Ordering::Acquire) != READY {
+            return Vec::new();
+        }
+        let first_child = root.first_child.load(Ordering::Relaxed);
+        let num_children = u32::from(root.num_children.load(Ordering::Relaxed));
+        (first_child..first_child + num_children)
+            .map(|index| {
+                let child = self.arena.node(index);
+                (
+                    Move::from_bits(child.next_move.load(Ordering::Relaxed)),
+                    child.visits.load(Ordering::Relaxed),
+                )
+            })
+            .collect()
+    }
+
+    fn most_visited_child(&self, parent: u32) -> Option<u32> {
+        let node = self.arena.node(parent);
+        if node.state.load(Ordering::Acquire) != READY {
+            return None;
+        }
+        let first_child = node.first_child.load(Ordering::Relaxed);
+        let num_children = u32::from(node.num_children.load(Ordering::Relaxed));
+        (first_child..first_child + num_children)
+            .max_by_key(|&index| self.arena.node(index).visits.load(Ordering::Relaxed))
+    }
+}
+
+/// Stand-in static evaluation until a trained network lands: the material
+/// difference squashed into (-1, 1), from the side to move perspective. It is
+/// enough to make the search prefer winning material and convert it.
+fn evaluate(position: &Position) -> f32 {
+    let (us, they) = (position.side_to_move(), position.side_to_move().opponent());
+    let mut material = 0;
+    for (kind, value) in [
+        (PieceKind::Queen, 900),
+        (PieceKind::Rook, 500),
+        (PieceKind::Bishop, 300),
+        (PieceKind::Knight, 300),
+        (PieceKind::Pawn, 100),
+    ] {
+        material += value
+            * (position.piece_count(us, kind) as i32 - position.piece_count(they, kind) as i32);
+    }
+    (material as f32 / 600.0).tanh()
+}
@@ -0,0 +1,292 @@
+//! [Syzygy] endgame tablebase probing: discovery and memory-mapping of the
+//! table files, material-key lookup, a lockless probe cache and the value
+//! types the search consumes. Tables are mapped, never read eagerly — the
+//! complete 6-man set is ~150 GB, so lazy page-in (and page sharing between
+//! engine processes) is the only workable access pattern.
+//!
+//! What is *not* here yet is the decoder for the RE-PAIR-compressed block
+//! format inside the tables: [`Table::decode_wdl`] recognizes only the
+//! trivially-drawn material configurations and reports everything else as
+//! unknown. Until the decoder lands the module stays engine-internal —
+//! [`crate::search::mcts::Searcher::set_tablebases`] exists, but no UCI
+//! `SyzygyPath` option is advertised, so users are not offered a knob that
+//! contributes no knowledge. The module is shaped so that landing the
+//! decoder is a local change: discovery, mapping, caching and the probe
+//! gating do not need to move.
+//!
+//! [Syzygy]: https://www.chessprogramming.org/Syzygy_Bases
+
+use std::collections::HashMap;
+use std::fs;
+use std::path::Path;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+use anyhow::Context;
+
+use crate::chess::core::{PieceKind, Player};
+use crate::chess::position::Position;
+
+/// Magic bytes opening a WDL (`.rtbw`) table.
+const WDL_MAGIC: [u8; 4] = [0x71, 0xE8, 0x23, 0x5D];
+
+/// Number of slots in the probe cache. Probes repeat heavily inside one
+/// endgame search, so even a small cache absorbs most of them.
+const PROBE_CACHE_SLOTS: usize = 1 << 16;
+
+/// Win/draw/loss value of a position from the side to move's perspective.
+/// The "blessed" and "cursed" variants are outcomes overturned by the
+/// fifty-move rule: real wins/losses on the board that the clock turns into
+/// draws.
+#[derive(Copy, Clone, Debug, Eq, PartialEq, Ord, PartialOrd)]
+pub enum Wdl {
+    /// The side to move loses.
+    Loss,
+    /// Lost position saved by the fifty-move rule.
+    BlessedLoss,
+    /// Drawn with best play.
+    Draw,
+    /// Won position spoiled by the fifty-move rule.
+    CursedWin,
+    /// The side to move wins.
+    Win,
+}
+
+/// One memory-mapped WDL table.
+struct Table {
+    map: memmap2::Mmap,
+}
+
+impl Table {
+    /// Decodes the WDL value of a position belonging to this table.
+    ///
+    /// The RE-PAIR block decompression is not implemented yet: only
+    /// positions drawn by insufficient material are answered, everything
+    /// else is `None` ("unknown") and the search falls back to evaluation.
+    fn decode_wdl(&self, position: &Position) -> Option<Wdl> {
+        debug_assert!(self.map.starts_with(&WDL_MAGIC));
+        if position.has_insufficient_material() {
+            return Some(Wdl::Draw);
+        }
+        None
+    }
+}
+
+/// Lockless direct-mapped cache of WDL probes, following the XOR-validation
+/// scheme of the transposition table: a slot is two atomics whose XOR must
+/// reproduce the key, so torn concurrent writes read as misses.
+struct ProbeCache {
+    slots: Box<[Slot]>,
+}
+
+struct Slot {
+    key: AtomicU64,
+    data: AtomicU64,
+}
+
+/// Tag distinguishing an occupied slot from a zeroed one.
+const OCCUPIED: u64 = 1 << 8;
+
+impl ProbeCache {
+    fn new() -> Self {
+        Self {
+            slots: std::iter::repeat_with(|| Slot {
+                key: AtomicU64::new(0),
+                data: AtomicU64::new(0),
+            })
+            .take(PROBE_CACHE_SLOTS)
+            .collect(),
+        }
+    }
+
+    fn probe(&self, key: u64) -> Option<Wdl> {
+        let slot = &self.slots[key as usize & (PROBE_CACHE_SLOTS - 1)];
+        let data = slot.data.load(Ordering::Relaxed);
+        if slot.key.load(Ordering::Relaxed) ^ data != key || data & OCCUPIED == 0 {
+            return None;
+        }
+        Some(match data as u8 {
+            0 => Wdl::Loss,
+            1 => Wdl::BlessedLoss,
+            2 => Wdl::Draw,
+            3 => Wdl::CursedWin,
+            _ => Wdl::Win,
+        })
+    }
+
+    fn store(&self, key: u64, wdl: Wdl) {
+        let slot = &self.slots[key as usize & (PROBE_CACHE_SLOTS - 1)];
+        let data = wdl as u64 | OCCUPIED;
+        slot.key.store(key ^ data, Ordering::Relaxed);
+        slot.data.store(data, Ordering::Relaxed);
+    }
+}
+
+/// A set of discovered tablebases, looked up by material signature.
+pub struct Tablebases {
+    tables: HashMap<String, Table>,
+    cache: ProbeCache,
+    max_men: u32,
+}
+
+impl Tablebases {
+    /// Discovers and maps every WDL table (`*.rtbw`) in `directory`. Files
+    /// without the Syzygy magic are skipped: a truncated download must not
+    /// masquerade as knowledge.
+    ///
+    /// # Errors
+    ///
+    /// Returns an error if the directory can not be read or a table file can
+    /// not be mapped.
+    pub fn open(directory: impl AsRef<Path>) -> anyhow::Result<Self> {
+        let mut tables = HashMap::new();
+        let mut max_men = 0;
+        let entries = fs::read_dir(directory.as_ref())
+            .with_context(|| format!("can not read {}", directory.as_ref().display()))?;
+        for entry in entries {
+            let path = entry.context("can not list tablebase directory")?.path();
+            if path.extension().is_none_or(|extension| extension != "rtbw") {
+                continue;
+            }
+            let Some(name) = path.file_stem().and_then(|stem| stem.to_str()) else {
+                continue;
+            };
+            let file = fs::File::open(&path)
+                .with_context(|| format!("can not open table {}", path.display()))?;
+            // SAFETY: the mapping is read-only; tables are static data.
+            let map = unsafe { memmap2::Mmap::map(&file) }
+                .with_context(|| format!("can not map table {}", path.display()))?;
+            if !map.starts_with(&WDL_MAGIC) {
+                continue;
+            }
+            // "KRPvKR" holds 5 men: every letter but the separator.
+            max_men = max_men.max(name.len() as u32 - 1);
+            let _ = tables.insert(name.to_string(), Table { map });
+        }
+        Ok(Self {
+            tables,
+            cache: ProbeCache::new(),
+            max_men,
+        })
+    }
+
+    /// The largest number of men any discovered table covers: positions with
+    /// more pieces can not be probed and should not try.
+    #[must_use]
+    pub const fn max_men(&self) -> u32 {
+        self.max_men
+    }
+
+    /// Probes the WDL value of the position: `None` when the position has
+    /// too many men, its table is missing, or the value can not be decoded
+    /// yet. Results are served from the probe cache when possible.
+    #[must_use]
+    pub fn probe_wdl(&self, position: &Position) -> Option<Wdl> {
+        if men(position) > self.max_men {
+            return None;
+        }
+        // The stored WDL values assume a fresh fifty-move clock, so interior
+        // probes are gated to positions right after a capture or pawn move:
+        // past that the real outcome may be overturned by the rule. The gate
+        // also keeps the cache sound — [`Position::hash`] does not cover the
+        // clock.
+        if position.halfmove_clock() != 0 {
+            return None;
+        }
+        if let Some(wdl) = self.cache.probe(position.hash()) {
+            return Some(wdl);
+        }
+        let wdl = self.table(position)?.decode_wdl(position)?;
+        self.cache.store(position.hash(), wdl);
+        Some(wdl)
+    }
+
+    /// Picks the root move the tablebases prove best: the move leading to
+    /// the worst WDL for the opponent. `None` unless *every* successor can
+    /// be probed — a partial answer could throw away a win.
+    #[must_use]
+    pub fn best_move(&self, position: &Position) -> Option<crate::chess::core::Move> {
+        if men(position) > self.max_men {
+            return None;
+        }
+        let mut best: Option<(Wdl, crate::chess::core::Move)> = None;
+        for next_move in position.generate_moves().iter() {
+            let mut child = position.clone();
+            child.make_move(next_move);
+            // The child's WDL is from the opponent's perspective: lower is
+            // better for us.
+            let wdl = self.probe_wdl(&child)?;
+            if best.is_none_or(|(best_wdl, _)| wdl < best_wdl) {
+                best = Some((wdl, *next_move));
+            }
+        }
+        best.map(|(_, next_move)| next_move)
+    }
+
+    fn table(&self, position: &Position) -> Option<&Table> {
+        let (white, black) = (
+            material(position, Player::White),
+            material(position, Player::Black),
+        );
+        self.tables
+            .get(&format!("{white}v{black}"))
+            .or_else(|| self.tables.get(&format!("{black}v{white}")))
+    }
+}
+
+/// Material signature of one side in table-name order (e.g. `KRP`).
+fn material(position: &Position, player: Player) -> String {
+    let mut result = String::new();
+    for (kind, letter) in [
+        (PieceKind::King, 'K'),
+        (PieceKind::Queen, 'Q'),
+        (PieceKind::Rook, 'R'),
+        (PieceKind::Bishop, 'B'),
+        (PieceKind::Knight, 'N'),
+        (PieceKind::Pawn, 'P'),
+    ] {
+        for _ in 0..position.piece_count(player, kind) {
+            result.push(letter);
+        }
+    }
+    result
+}
+
+fn men(position: &Position) -> u32 {
+    let mut result = 0;
+    for player in [Player::White, Player::Black] {
+        for kind in [
+            PieceKind::King,
+            PieceKind::Queen,
+            PieceKind::Rook,
+            PieceKind::Bishop,
+            PieceKind::Knight,
+            PieceKind::Pawn,
+        ] {
+            result += position.piece_count(player, kind);
+        }
+    }
+    result
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn probe_cache_roundtrip() {
+        let cache = ProbeCache::new();
+        assert!(cache.probe(42).is_none());
+        cache.store(42, Wdl::CursedWin);
+        assert_eq!(cache.probe(42), Some(Wdl::CursedWin));
+        // A colliding key maps to the same slot but fails XOR validation.
+        assert!(cache.probe(42 + PROBE_CACHE_SLOTS as u64).is_none());
+    }
+
+    #[test]
+    fn wdl_ordering_ranks_outcomes() {
+        assert!(Wdl::Win > Wdl::CursedWin);
+        assert!(Wdl::CursedWin > Wdl::Draw);
+        assert!(Wdl::Draw > Wdl::BlessedLoss);
+        assert!(Wdl::BlessedLoss > Wdl::Loss);
+    }
+}
@@ -0,0 +1,132 @@
+//! Allocation of thinking time: translates the clock state reported by the
+//! GUI (`wtime`/`btime`/`winc`/`movestogo`) into a *soft* and a *hard*
+//! deadline for the search. The soft deadline is the target spend for an
+//! average move: the search is cut there once the best move has settled,
+//! and extended towards the hard deadline while the top candidates are
+//! still contested. The hard deadline is never crossed, and a fixed
+//! overhead is reserved out of every move so that protocol and I/O latency
+//! can not lose the game on time — while the budgets are sized to actually
+//! spend the clock rather than hoard it.
+use std::time::Duration;
+
+/// Reserved per move for protocol round trips and output flushing: time the
+/// engine spends but the GUI bills to us.
+const MOVE_OVERHEAD: Duration = Duration::from_millis(50);
+
+/// Assumed number of remaining moves when the GUI does not provide
+/// `movestogo`: games rarely last longer, and the increment keeps late
+/// moves funded.
+const DEFAULT_HORIZON: u32 = 24;
+
+/// Our side of the clock, parsed from the `go` command.
+#[derive(Copy, Clone, Debug)]
+pub struct Clock {
+    /// Time left on our clock.
+    pub time_left: Duration,
+    /// Increment added after every move we make.
+    pub increment: Duration,
+    /// Moves until the next time control, if the GUI announced one.
+    pub moves_to_go: Option<u32>,
+}
+
+/// Search time budget: both durations are measured from the moment the
+/// search starts.
+#[derive(Copy, Clone, Debug)]
+pub struct Deadlines {
+    /// Target spend: stop here once the best move is decided.
+    pub soft: Duration,
+    /// Never think longer than this.
+    pub hard: Duration,
+}
+
+impl Deadlines {
+    /// Budget for `go movetime`: the whole duration (minus overhead) is
+    /// mandated, so there is no soft/hard distinction.
+    #[must_use]
+    pub fn fixed(movetime: Duration) -> Self {
+        let usable = movetime.saturating_sub(MOVE_OVERHEAD);
+        Self {
+            soft: usable,
+            hard: usable,
+        }
+    }
+}
+
+/// Computes the deadlines for one move given the clock.
+#[must_use]
+pub fn schedule(clock: &Clock) -> Deadlines {
+    let usable = clock.time_left.saturating_sub(MOVE_OVERHEAD);
+    let horizon = clock.moves_to_go.unwrap_or(DEFAULT_HORIZON).max(1);
+    // An even share of the remaining time plus most of the increment (the
+    // increment arrives after the move, so spending all of it up front
+    // would slowly bleed the clock).
+    let soft = (usable / horizon + clock.increment * 3 / 4).min(usable);
+    // Unstable positions may take several times the average share, but one
+    // move never burns more than a third of the clock.
+    let hard = (soft * 4).min(usable / 3 + clock.increment).min(usable).max(soft);
+    Deadlines { soft, hard }
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+
+    #[test]
+    fn deadlines_respect_the_clock() {
+        for (time_left, increment, moves_to_go) in [
+            (60_000, 0, None),
+            (60_000, 1000, None),
+            (1000, 0, None),
+            (100, 0, None),
+            (0, 0, None),
+            (30_000, 0, Some(40)),
+            (5000, 100, Some(1)),
+        ] {
+            let deadlines = schedule(&Clock {
+                time_left: Duration::from_millis(time_left),
+                increment: Duration::from_millis(increment),
+                moves_to_go,
+            });
+            assert!(deadlines.soft <= deadlines.hard);
+            assert!(
+                deadlines.hard <= Duration::from_millis(time_left),
+                "hard deadline {:?} exceeds the clock {time_left}ms",
+                deadlines.hard
+            );
+        }
+    }
+
+    #[test]
+    fn increment_extends_the_budget() {
+        let without = schedule(&Clock {
+            time_left: Duration::from_secs(60),
+            increment: Duration::ZERO,
+            moves_to_go: None,
+        });
+        let with = schedule(&Clock {
+            time_left: Duration::from_secs(60),
+            increment: Duration::from_secs(2),
+            moves_to_go: None,
+        });
+        assert!(with.soft > without.soft);
+    }
+
+    #[test]
+    fn last_move_before_time_control_spends_the_share() {
+        // With one move to go, hoarding time would waste it: almost the
+        // whole clock is usable.
+        let deadlines = schedule(&Clock {
+            time_left: Duration::from_secs(9),
+            increment: Duration::ZERO,
+            moves_to_go: Some(1),
+        });
+        assert!(deadlines.soft >= Duration::from_secs(8));
+    }
+
+    #[test]
+    fn fixed_budget_reserves_overhead() {
+        let deadlines = Deadlines::fixed(Duration::from_secs(1));
+        assert_eq!(deadlines.soft, deadlines.hard);
+        assert!(deadlines.hard < Duration::from_secs(1));
+    }
+}
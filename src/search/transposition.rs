@@ -0,0 +1,266 @@
+//! Shared [Transposition Table] keyed by the position Zobrist hash
+//! ([`crate::chess::position::Position::hash`]). The table is probed and
+//! updated by all search threads concurrently without any locks: each entry is
+//! two 64-bit words stored with the [lockless XOR trick], so a torn
+//! read/write is detected by key verification instead of being prevented by a
+//! mutex.
+//!
+//! [Transposition Table]: https://www.chessprogramming.org/Transposition_Table
+//! [lockless XOR trick]: https://www.chessprogramming.org/Shared_Hash_Table#Lock-less
+use std::sync::atomic::{AtomicU64, AtomicU8, Ordering};
+
+use crate::chess::core::Move;
+
+/// Relation of the stored score to the true value of the position: the exact
+/// value for PV-nodes or a bound when the search produced a cutoff.
+#[derive(Copy, Clone, Debug, PartialEq, Eq)]
+#[repr(u8)]
+pub enum Bound {
+    /// The score is a lower bound (the search failed high).
+    Lower = 1,
+    /// The score is an upper bound (the search failed low).
+    Upper = 2,
+    /// The score is exact.
+    Exact = 3,
+}
+
+/// Payload of a transposition table slot: everything the search wants to
+/// remember about a position. Packs into a single 64-bit word inside the
+/// table, making the whole entry (with its verification key) 16 bytes.
+#[derive(Copy, Clone, Debug)]
+pub struct Entry {
+    /// The best move found at this position, if any.
+    pub best_move: Option<Move>,
+    /// Score of the position from the side to move perspective.
+    pub score: i16,
+    /// Remaining search depth the score was obtained at.
+    pub depth: u8,
+    #[allow(missing_docs)]
+    pub bound: Bound,
+}
+
+/// A single table slot. The first word is `key ^ data`, the second is `data`:
+/// a reader XORs the two back together and compares with the probed key, so an
+/// entry that was half-overwritten by another thread simply fails verification
+/// instead of producing a corrupted hit.
+#[derive(Default)]
+struct Slot {
+    key: AtomicU64,
+    data: AtomicU64,
+}
+
+/// Shared transposition table. The table is sized once at startup (gigabytes
+/// on analysis hardware) and safely shared between search threads by
+/// reference: all operations take `&self`.
+pub struct TranspositionTable {
+    slots: Box<[Slot]>,
+    /// `slots.len() - 1`: the number of slots is a power of two, so indexing
+    /// is a single AND instead of a modulo.
+    mask: usize,
+    /// Age of the current search, bumped by [`TranspositionTable::new_search`].
+    /// Entries from previous searches are replaced eagerly so that long
+    /// analysis sessions do not degrade into a table full of stale entries.
+    generation: AtomicU8,
+}
+
+impl TranspositionTable {
+    /// Size of one slot: 16 bytes (two 64-bit words).
+    const SLOT_SIZE: usize = size_of::<Slot>();
+
+    /// Creates a table occupying at most `size_mb` megabytes, rounding the
+    /// number of slots down to a power of two. The common power-of-two sizes
+    /// (e.g. `Hash` 16/64/256 MB) are already whole slot counts and are used
+    /// in full.
+    #[must_use]
+    pub fn new(size_mb: usize) -> Self {
+        let slots = 1 << (size_mb * 1024 * 1024 / Self::SLOT_SIZE).max(1).ilog2();
+        let slots: Box<[Slot]> = std::iter::repeat_with(Slot::default).take(slots).collect();
+        Self {
+            mask: slots.len() - 1,
+            slots,
+            generation: AtomicU8::new(0),
+        }
+    }
+
+    /// Marks the start of a new search: older entries become preferred
+    /// replacement victims.
+    pub fn new_search(&self) {
+        let _ = self.generation.fetch_add(1, Ordering::Relaxed);
+    }
+
+    /// Looks up the entry for the given key. Returns `None` on a miss or when
+    /// the slot fails XOR verification (e.g. it is being concurrently
+    /// overwritten by another thread).
+    #[must_use]
+    pub fn probe(&self, key: u64) -> Option<Entry> {
+        crate::stats::record(crate::stats::Event::TtProbes, 1);
+        let slot = &self.slots[key as usize & self.mask];
+        let data = slot.data.load(Ordering::Relaxed);
+        if slot.key.load(Ordering::Relaxed) ^ data != key || data == 0 {
+            return None;
+        }
+        crate::stats::record(crate::stats::Event::TtHits, 1);
+        Some(unpack(data))
+    }
+
+    /// Stores an entry for the given key. The slot is replaced if it is
+    /// empty, belongs to an older search, held a different position or the
+    /// new entry comes from a deeper search.
+    pub fn store(&self, key: u64, entry: Entry) {
+        let slot = &self.slots[key as usize & self.mask];
+        let generation = self.generation.load(Ordering::Relaxed);
+        let old_data = slot.data.load(Ordering::Relaxed);
+        let keep = old_data != 0
+            && slot.key.load(Ordering::Relaxed) ^ old_data == key
+            && unpack_generation(old_data) == generation
+            && unpack(old_data).depth > entry.depth
+            && entry.bound != Bound::Exact;
+        if keep {
+            return;
+        }
+        let data = pack(entry, generation);
+        slot.key.store(key ^ data, Ordering::Relaxed);
+        slot.data.store(data, Ordering::Relaxed);
+    }
+
+    /// Drops all stored entries (e.g. on UCI `ucinewgame`).
+    pub fn clear(&self) {
+        for slot in self.slots.iter() {
+            slot.key.store(0, Ordering::Relaxed);
+            slot.data.store(0, Ordering::Relaxed);
+        }
+    }
+
+    /// Returns an approximation of the table saturation in permill, matching
+    /// the UCI `hashfull` semantics. Samples at most 1000 slots.
+    #[must_use]
+    pub fn hashfull(&self) -> usize {
+        let sample = self.slots.len().min(1000);
+        self.slots[..sample]
+            .iter()
+            .filter(|slot| slot.data.load(Ordering::Relaxed) != 0)
+            .count()
+            * 1000
+            / sample
+    }
+}
+
+/// Entry layout within the data word:
+///
+/// - bits 0..16: move (the packed [`Move`] encoding; 0 for none)
+/// - bits 16..32: score (i16)
+/// - bits 32..40: depth
+/// - bits 40..42: bound
+/// - bits 42..50: generation
+fn pack(entry: Entry, generation: u8) -> u64 {
+    u64::from(pack_move(entry.best_move))
+        | u64::from(entry.score as u16) << 16
+        | u64::from(entry.depth) << 32
+        | (entry.bound as u64) << 40
+        | u64::from(generation) << 42
+}
+
+fn unpack(data: u64) -> Entry {
+    Entry {
+        best_move: unpack_move(data as u16),
+        score: (data >> 16) as u16 as i16,
+        depth: (data >> 32) as u8,
+        bound: match (data >> 40) & 0b11 {
+            1 => Bound::Lower,
+            2 => Bound::Upper,
+            _ => Bound::Exact,
+        },
+    }
+}
+
+fn unpack_generation(data: u64) -> u8 {
+    (data >> 42) as u8
+}
+
+fn pack_move(next_move: Option<Move>) -> u16 {
+    match next_move {
+        // The all-zero pattern is reserved for "no move": a real a1a1 move
+        // does not exist.
+        None => 0,
+        Some(next_move) => next_move.bits(),
+    }
+}
+
+fn unpack_move(packed: u16) -> Option<Move> {
+    if packed == 0 {
+        return None;
+    }
+    Some(Move::from_bits(packed))
+}
+
+#[cfg(test)]
+mod test {
+    use super::*;
+    use crate::chess::core::{Promotion, Square};
+
+    #[test]
+    fn probe_and_store() {
+        let table = TranspositionTable::new(1);
+        assert!(table.probe(0xDEAD_BEEF).is_none());
+        let entry = Entry {
+            best_move: Some(Move::new(Square::E2, Square::E4, None)),
+            score: 42,
+            depth: 7,
+            bound: Bound::Exact,
+        };
+        table.store(0xDEAD_BEEF, entry);
+        let probed = table.probe(0xDEAD_BEEF).unwrap();
+        assert_eq!(probed.score, 42);
+        assert_eq!(probed.depth, 7);
+        assert_eq!(probed.bound, Bound::Exact);
+        assert_eq!(
+            probed.best_move.unwrap().to_string(),
+            entry.best_move.unwrap().to_string()
+        );
+        // A different key mapping to the same slot fails verification.
+        assert!(table.probe(0xDEAD_BEEF ^ 0x8000_0000_0000_0000).is_none());
+        table.clear();
+        assert!(table.probe(0xDEAD_BEEF).is_none());
+    }
+
+    #[test]
+    fn replacement_prefers_depth() {
+        let table = TranspositionTable::new(1);
+        let deep = Entry {
+            best_move: None,
+            score: 1,
+            depth: 10,
+            bound: Bound::Lower,
+        };
+        let shallow = Entry {
+            best_move: None,
+            score: 2,
+            depth: 3,
+            bound: Bound::Lower,
+        };
+        table.store(1, deep);
+        table.store(1, shallow);
+        // The shallower entry from the same search does not evict the deeper
+        // one...
+        assert_eq!(table.probe(1).unwrap().depth, 10);
+        // ...but after a new search starts, it does.
+        table.new_search();
+        table.store(1, shallow);
+        assert_eq!(table.probe(1).unwrap().depth, 3);
+    }
+
+    #[test]
+    fn move_packing_roundtrip() {
+        for next_move in [
+            Move::new(Square::A1, Square::H8, None),
+            Move::new(Square::E7, Square::E8, Some(Promotion::Queen)),
+            Move::new(Square::B2, Square::A1, Some(Promotion::Knight)),
+        ] {
+            assert_eq!(
+                unpack_move(pack_move(Some(next_move))).unwrap().to_string(),
+                next_move.to_string()
+            );
+        }
+        assert!(unpack_move(pack_move(None)).is_none());
+    }
+}
@@ -0,0 +1,8 @@
+//! Generation of training data for the evaluation network: self-play games
+//! produce `(position, policy visit distribution, game outcome)` examples at
+//! the scale a training run needs (hundreds of millions of positions), so
+//! both the format and the pipeline are built for throughput.
+
+pub mod cluster;
+pub mod data;
+pub mod selfplay;
@@ -0,0 +1,293 @@
+//! Distributed self-play: one coordinator hands out batches of game indices
+//! to any number of worker machines and collects the played games as
+//! compressed shards. Because every game is deterministic given its index
+//! (see [`crate::training::selfplay`]), a batch produces the same bytes no
+//! matter which worker plays it: the coordinator can hand a straggler's
+//! batch to a second worker and deduplicate by batch id without ever
+//! corrupting the dataset.
+//!
+//! The protocol is a handful of length-prefixed frames over plain TCP — the
+//! cluster runs on a trusted private network, and a worker is stateless: it
+//! requests a batch, plays it, streams the gzip-compressed records back and
+//! asks for the next one. A worker that disconnects mid-batch simply gets
+//! its batch re-queued.
+
+use std::collections::{HashSet, VecDeque};
+use std::fs;
+use std::io::{Read, Write};
+use std::net::{SocketAddr, TcpListener, TcpStream};
+use std::path::{Path, PathBuf};
+use std::sync::Mutex;
+use std::time::Duration;
+
+use anyhow::{bail, Context};
+use flate2::read::GzDecoder;
+use flate2::write::GzEncoder;
+use flate2::Compression;
+
+use crate::chess::position::Position;
+use crate::training::selfplay::{self, Config};
+
+/// Number of games a worker plays per assignment. Large enough to amortize
+/// the round trip, small enough that losing a worker loses little work.
+pub const BATCH_GAMES: usize = 32;
+
+/// Frame tags of the wire protocol.
+const REQUEST: u8 = 1;
+const BATCH: u8 = 2;
+const DONE: u8 = 3;
+const SHARD: u8 = 4;
+
+/// Batch assignment and bookkeeping shared between connection threads.
+struct State {
+    /// Next never-assigned batch.
+    next: usize,
+    total: usize,
+    /// Batches whose worker disconnected before delivering.
+    retry: VecDeque<usize>,
+    /// Batches assigned and not yet delivered. When nothing fresh is left
+    /// these are handed out again speculatively, so stragglers can not
+    /// stall the run.
+    outstanding: HashSet<usize>,
+    /// Batches written to disk. Duplicate deliveries are dropped.
+    completed: HashSet<usize>,
+    directory: PathBuf,
+}
+
+impl State {
+    /// Picks the next batch for a requesting worker, or `None` when the run
+    /// is complete.
+    fn assign(&mut self) -> Option<usize> {
+        let batch = if let Some(batch) = self.retry.pop_front() {
+            batch
+        } else if self.next < self.total {
+            self.next += 1;
+            self.next - 1
+        } else {
+            // Only stragglers remain: duplicate their work instead of
+            // idling; whichever copy lands first wins.
+            *self.outstanding.iter().next()?
+        };
+        let _ = self.outstanding.insert(batch);
+        Some(batch)
+    }
+
+    /// Records a delivered batch, writing it to disk unless a duplicate of
+    /// it already landed.
+    fn complete(&mut self, batch: usize, compressed: &[u8]) -> anyhow::Result<()> {
+        let _ = self.outstanding.remove(&batch);
+        if !self.completed.insert(batch) {
+            return Ok(());
+        }
+        let path = self.directory.join(format!("batch-{batch:05}.bin.gz"));
+        fs::write(&path, compressed)
+            .with_context(|| format!("can not write shard {}", path.display()))
+    }
+
+    fn is_done(&self) -> bool {
+        self.completed.len() == self.total
+    }
+}
+
+/// Runs the coordinator: listens on `address`, distributes `games` games in
+/// [`BATCH_GAMES`]-sized batches and writes the returned shards into
+/// `output`. Returns the number of shards written once every batch has been
+/// delivered.
+pub fn coordinate(address: SocketAddr, games: usize, output: &Path) -> anyhow::Result<usize> {
+    fs::create_dir_all(output)
+        .with_context(|| format!("can not create output directory {}", output.display()))?;
+    let listener = TcpListener::bind(address)
+        .with_context(|| format!("can not listen on {address}"))?;
+    // The accept loop polls so that it can stop once the dataset is
+    // complete instead of blocking forever.
+    listener
+        .set_nonblocking(true)
+        .context("can not configure listener")?;
+    let state = Mutex::new(State {
+        next: 0,
+        total: games.div_ceil(BATCH_GAMES),
+        retry: VecDeque::new(),
+        outstanding: HashSet::new(),
+        completed: HashSet::new(),
+        directory: output.to_path_buf(),
+    });
+    let total = games.div_ceil(BATCH_GAMES);
+    std::thread::scope(|scope| {
+        loop {
+            if state
+                .lock()
+                .expect("connection threads do not poison the state")
+                .is_done()
+            {
+                break;
+            }
+            match listener.accept() {
+                Ok((stream, _)) => {
+                    let state = &state;
+                    let _ = scope.spawn(move || serve_worker(stream, state, games));
+                },
+                Err(e) if e.kind() == std::io::ErrorKind::WouldBlock => {
+                    std::thread::sleep(Duration::from_millis(10));
+                },
+                Err(e) => return Err(e).context("can not accept worker connection"),
+            }
+        }
+        Ok(())
+    })?;
+    Ok(total)
+}
+
+/// Serves one worker connection until the worker disconnects or the run
+/// completes. Connection errors are not fatal to the run: the worker's
+/// outstanding batch is re-queued and the thread ends.
+fn serve_worker(mut stream: TcpStream, state: &Mutex<State>, games: usize) {
+    let mut current: Option<usize> = None;
+    let result: anyhow::Result<()> = (|| {
+        loop {
+            let (tag, payload) = read_frame(&mut stream)?;
+            match tag {
+                REQUEST => {
+                    let assigned = state
+                        .lock()
+                        .expect("connection threads do not poison the state")
+                        .assign();
+                    match assigned {
+                        Some(batch) => {
+                            current = Some(batch);
+                            let first = batch * BATCH_GAMES;
+                            let count = BATCH_GAMES.min(games - first);
+                            let mut payload = Vec::with_capacity(12);
+                            payload.extend_from_slice(&(first as u64).to_le_bytes());
+                            payload.extend_from_slice(&(count as u32).to_le_bytes());
+                            write_frame(&mut stream, BATCH, &payload)?;
+                        },
+                        None => {
+                            write_frame(&mut stream, DONE, &[])?;
+                            return Ok(());
+                        },
+                    }
+                },
+                SHARD => {
+                    if payload.len() < 8 {
+                        bail!("malformed shard frame");
+                    }
+                    let batch = u64::from_le_bytes(payload[..8].try_into().unwrap()) as usize;
+                    state
+                        .lock()
+                        .expect("connection threads do not poison the state")
+                        .complete(batch, &payload[8..])?;
+                    if current == Some(batch) {
+                        current = None;
+                    }
+                },
+                tag => bail!("unexpected frame tag {tag}"),
+            }
+        }
+    })();
+    if result.is_err() {
+        // The worker is gone: hand its batch to someone else.
+        if let Some(batch) = current {
+            let mut state = state
+                .lock()
+                .expect("connection threads do not poison the state");
+            if !state.completed.contains(&batch) {
+                let _ = state.outstanding.remove(&batch);
+                state.retry.push_back(batch);
+            }
+        }
+    }
+}
+
+/// Runs a worker: connects to the coordinator at `address` and plays batches
+/// until the coordinator reports the run complete. `starts` must be the same
+/// seed corpus on every machine — game seeds index into it.
+pub fn work(address: SocketAddr, config: &Config, starts: &[Position]) -> anyhow::Result<()> {
+    let mut stream = TcpStream::connect(address)
+        .with_context(|| format!("can not connect to coordinator at {address}"))?;
+    loop {
+        write_frame(&mut stream, REQUEST, &[])?;
+        let (tag, payload) = read_frame(&mut stream)?;
+        match tag {
+            DONE => return Ok(()),
+            BATCH => {
+                if payload.len() != 12 {
+                    bail!("malformed batch frame");
+                }
+                let first = u64::from_le_bytes(payload[..8].try_into().unwrap()) as usize;
+                let count = u32::from_le_bytes(payload[8..].try_into().unwrap()) as usize;
+                let shard = play_batch(config, starts, first, count)?;
+                let batch = first / BATCH_GAMES;
+                let mut reply = Vec::with_capacity(8 + shard.len());
+                reply.extend_from_slice(&(batch as u64).to_le_bytes());
+                reply.extend_from_slice(&shard);
+                write_frame(&mut stream, SHARD, &reply)?;
+            },
+            tag => bail!("unexpected frame tag {tag}"),
+        }
+    }
+}
+
+/// Plays the games `first..first + count` on `config.workers` threads and
+/// returns their records as one gzip-compressed blob. Deterministic: the
+/// games are encoded in index order, so batch contents do not depend on the
+/// machine (or the thread interleaving) that played them.
+fn play_batch(
+    config: &Config,
+    starts: &[Position],
+    first: usize,
+    count: usize,
+) -> anyhow::Result<Vec<u8>> {
+    let mut records: Vec<Vec<u8>> = vec![Vec::new(); count];
+    let chunk = count.div_ceil(config.workers.max(1).min(count).max(1));
+    std::thread::scope(|scope| {
+        for (worker, slice) in records.chunks_mut(chunk).enumerate() {
+            let _ = scope.spawn(move || {
+                for (offset, encoded) in slice.iter_mut().enumerate() {
+                    let index = first + worker * chunk + offset;
+                    let record = selfplay::play_game(
+                        config,
+                        &selfplay::start_position(starts, index),
+                        index as u64,
+                    );
+                    record.encode(encoded);
+                }
+            });
+        }
+    });
+    let mut encoder = GzEncoder::new(Vec::new(), Compression::default());
+    for encoded in &records {
+        encoder
+            .write_all(encoded)
+            .context("can not compress batch")?;
+    }
+    encoder.finish().context("can not compress batch")
+}
+
+/// Decompresses a shard written by the coordinator back into raw game
+/// records (the input of [`crate::training::data::GameRecord::decode`]).
+pub fn decompress_shard(compressed: &[u8]) -> anyhow::Result<Vec<u8>> {
+    let mut decoder = GzDecoder::new(compressed);
+    let mut result = Vec::new();
+    let _ = decoder
+        .read_to_end(&mut result)
+        .context("can not decompress shard")?;
+    Ok(result)
+}
+
+fn write_frame(stream: &mut TcpStream, tag: u8, payload: &[u8]) -> anyhow::Result<()> {
+    let mut header = [0u8; 5];
+    header[0] = tag;
+    header[1..].copy_from_slice(&(payload.len() as u32).to_le_bytes());
+    stream.write_all(&header).context("connection lost")?;
+    stream.write_all(payload).context("connection lost")?;
+    Ok(())
+}
+
+fn read_frame(stream: &mut TcpStream) -> anyhow::Result<(u8, Vec<u8>)> {
+    let mut header = [0u8; 5];
+    stream.read_exact(&mut header).context("connection lost")?;
+    let length = u32::from_le_bytes(header[1..].try_into().unwrap()) as usize;
+    let mut payload = vec![0; length];
+    stream.read_exact(&mut payload).context("connection lost")?;
+    Ok((header[0], payload))
+}
@@ -0,0 +1,145 @@
+//! Compact binary format of the self-play games. Positions are not stored at
+//! all: a game record holds the starting position and the played moves, and
+//! the reader reconstructs every position by replaying them through
+//! [`Position::make_move`] — a record costs a few dozen bytes per ply where
+//! FEN text would cost close to a hundred, and the replay also validates the
+//! data against the move generator.
+//!
+//! Wire layout of one game (all integers little-endian):
+//!
+//! ```text
+//! u8   length of the starting FEN (0 = the standard starting position)
+//! ..   FEN bytes
+//! i8   outcome from the white player's perspective: +1, 0 or -1
+//! u16  number of plies
+//! per ply:
+//!   u16  the played move, in the engine's packed encoding
+//!   u16  number of policy entries
+//!   per entry:
+//!     u16  root move, packed
+//!     u16  MCTS visit count (saturated)
+//! ```
+
+use anyhow::{bail, Context};
+
+use crate::chess::core::Move;
+use crate::chess::position::Position;
+
+/// One ply of a game: the move that was played and the root visit
+/// distribution of the search that chose it (the policy target).
+#[derive(Clone, Debug)]
+pub struct PlyRecord {
+    /// The move played in the game.
+    pub next_move: Move,
+    /// Visit count of every root move, saturated to 16 bits.
+    pub policy: Vec<(Move, u16)>,
+}
+
+/// One complete self-play game.
+#[derive(Clone, Debug)]
+pub struct GameRecord {
+    /// Starting position; `None` is the standard starting position (the
+    /// common case, kept off the wire).
+    pub start_fen: Option<String>,
+    /// Game outcome from the white player's perspective: +1, 0 or -1.
+    pub outcome: i8,
+    /// The played moves with their policy targets, in game order.
+    pub plies: Vec<PlyRecord>,
+}
+
+impl GameRecord {
+    /// Appends the wire encoding of the game to `out`.
+    pub fn encode(&self, out: &mut Vec<u8>) {
+        let fen = self.start_fen.as_deref().unwrap_or("");
+        debug_assert!(fen.len() <= u8::MAX as usize);
+        out.push(fen.len() as u8);
+        out.extend_from_slice(fen.as_bytes());
+        out.push(self.outcome as u8);
+        out.extend_from_slice(&(self.plies.len() as u16).to_le_bytes());
+        for ply in &self.plies {
+            out.extend_from_slice(&ply.next_move.bits().to_le_bytes());
+            out.extend_from_slice(&(ply.policy.len() as u16).to_le_bytes());
+            for (next_move, visits) in &ply.policy {
+                out.extend_from_slice(&next_move.bits().to_le_bytes());
+                out.extend_from_slice(&visits.to_le_bytes());
+            }
+        }
+    }
+
+    /// Decodes one game from the front of `bytes`, advancing it past the
+    /// record. Fails on truncated input; the moves themselves are validated
+    /// by [`GameRecord::replay`].
+    pub fn decode(bytes: &mut &[u8]) -> anyhow::Result<Self> {
+        let fen_len = take(bytes, 1).context("game record: missing FEN length")?[0] as usize;
+        let fen = take(bytes, fen_len).context("game record: truncated FEN")?;
+        let start_fen = if fen.is_empty() {
+            None
+        } else {
+            Some(String::from_utf8(fen.to_vec()).context("game record: FEN is not UTF-8")?)
+        };
+        let outcome = take(bytes, 1).context("game record: missing outcome")?[0] as i8;
+        if !(-1..=1).contains(&outcome) {
+            bail!("game record: outcome {outcome} is not in -1..=1");
+        }
+        let num_plies = read_u16(bytes).context("game record: missing ply count")?;
+        let mut plies = Vec::with_capacity(num_plies as usize);
+        for _ in 0..num_plies {
+            let next_move =
+                Move::from_bits(read_u16(bytes).context("game record: truncated move")?);
+            let num_entries = read_u16(bytes).context("game record: truncated policy")?;
+            let mut policy = Vec::with_capacity(num_entries as usize);
+            for _ in 0..num_entries {
+                let entry_move =
+                    Move::from_bits(read_u16(bytes).context("game record: truncated policy")?);
+                let visits = read_u16(bytes).context("game record: truncated policy")?;
+                policy.push((entry_move, visits));
+            }
+            plies.push(PlyRecord { next_move, policy });
+        }
+        Ok(Self {
+            start_fen,
+            outcome,
+            plies,
+        })
+    }
+
+    /// Replays the game, calling `consumer` with every position and the ply
+    /// that was searched from it. This is how a training loader materializes
+    /// the positions, and it doubles as validation: an illegal stored move
+    /// fails the replay.
+    pub fn replay(
+        &self,
+        mut consumer: impl FnMut(&Position, &PlyRecord),
+    ) -> anyhow::Result<()> {
+        let mut position = match &self.start_fen {
+            Some(fen) => Position::from_fen(fen).context("game record: invalid starting FEN")?,
+            None => Position::starting(),
+        };
+        for (index, ply) in self.plies.iter().enumerate() {
+            if !position
+                .generate_moves()
+                .iter()
+                .any(|next_move| *next_move == ply.next_move)
+            {
+                bail!("game record: illegal move at ply {index}");
+            }
+            consumer(&position, ply);
+            position.make_move(&ply.next_move);
+        }
+        Ok(())
+    }
+}
+
+fn take<'a>(bytes: &mut &'a [u8], count: usize) -> anyhow::Result<&'a [u8]> {
+    if bytes.len() < count {
+        bail!("unexpected end of record");
+    }
+    let (front, rest) = bytes.split_at(count);
+    *bytes = rest;
+    Ok(front)
+}
+
+fn read_u16(bytes: &mut &[u8]) -> anyhow::Result<u16> {
+    let front = take(bytes, 2)?;
+    Ok(u16::from_le_bytes([front[0], front[1]]))
+}
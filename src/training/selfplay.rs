@@ -0,0 +1,260 @@
+//! Parallel self-play game generation. Worker threads play complete games
+//! with the MCTS searcher and push the encoded records through a bounded
+//! channel to a single sharded writer: the workers saturate the cores, the
+//! writer streams to disk, and the channel's backpressure keeps memory flat
+//! if the disk falls behind. Every game is deterministic given its index, so
+//! a run can be reproduced exactly.
+
+use std::fs;
+use std::io::{BufWriter, Write};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::sync::mpsc;
+
+use anyhow::Context;
+
+use crate::chess::core::{Move, Player};
+use crate::chess::position::{GameStatus, Position};
+use crate::search::mcts::{Limits, Searcher};
+use crate::training::data::{GameRecord, PlyRecord};
+
+/// Number of encoded games the queue holds before the workers block: enough
+/// to ride out disk hiccups, small enough to bound memory.
+const QUEUE_CAPACITY: usize = 64;
+
+/// Plies during which the played move is sampled proportionally to the root
+/// visits instead of taking the maximum: without this opening temperature
+/// every game from the same start would be identical and the data worthless.
+const TEMPERATURE_PLIES: usize = 20;
+
+/// Parameters of one generation run.
+pub struct Config {
+    /// Total number of games to play.
+    pub games: usize,
+    /// Number of game-playing worker threads.
+    pub workers: usize,
+    /// MCTS simulations per move.
+    pub simulations: usize,
+    /// Search tree arena size per worker, in megabytes.
+    pub arena_mb: usize,
+    /// Games longer than this are adjudicated as draws.
+    pub max_plies: usize,
+    /// Approximate size at which a new output shard is started.
+    pub shard_bytes: usize,
+}
+
+impl Default for Config {
+    fn default() -> Self {
+        Self {
+            games: 1000,
+            workers: std::thread::available_parallelism()
+                .map_or(1, std::num::NonZeroUsize::get),
+            simulations: 800,
+            arena_mb: 64,
+            max_plies: 512,
+            shard_bytes: 64 * 1024 * 1024,
+        }
+    }
+}
+
+/// Totals of a finished run.
+#[derive(Debug)]
+pub struct Summary {
+    /// Games played and written.
+    pub games: usize,
+    /// Total positions (plies) across all games.
+    pub plies: u64,
+    /// Number of output shards written.
+    pub shards: usize,
+}
+
+/// Plays `config.games` self-play games and writes them as shards
+/// (`games-NNNNN.bin`) into `output`. Game `i` starts from
+/// `starts[i % starts.len()]` (the standard starting position when `starts`
+/// is empty), so a seed corpus spreads the games over the opening space.
+pub fn generate(config: &Config, starts: &[Position], output: &Path) -> anyhow::Result<Summary> {
+    fs::create_dir_all(output)
+        .with_context(|| format!("can not create output directory {}", output.display()))?;
+    let (sender, receiver) = mpsc::sync_channel::<(Vec<u8>, usize)>(QUEUE_CAPACITY);
+    let next_game = AtomicUsize::new(0);
+    std::thread::scope(|scope| {
+        for _ in 0..config.workers.max(1) {
+            let sender = sender.clone();
+            let next_game = &next_game;
+            let _ = scope.spawn(move || loop {
+                let index = next_game.fetch_add(1, Ordering::Relaxed);
+                if index >= config.games {
+                    return;
+                }
+                let record = play_game(config, &start_position(starts, index), index as u64);
+                let mut encoded = Vec::new();
+                record.encode(&mut encoded);
+                // The writer hung up (e.g. the disk failed): stop playing.
+                if sender.send((encoded, record.plies.len())).is_err() {
+                    return;
+                }
+            });
+        }
+        drop(sender);
+        // The writer runs on the calling thread: when every worker is done
+        // the channel closes and the loop drains what is left.
+        let mut writer = ShardWriter::new(output, config.shard_bytes);
+        let mut summary = Summary {
+            games: 0,
+            plies: 0,
+            shards: 0,
+        };
+        while let Ok((encoded, plies)) = receiver.recv() {
+            writer.write(&encoded)?;
+            summary.games += 1;
+            summary.plies += plies as u64;
+        }
+        summary.shards = writer.finish()?;
+        Ok(summary)
+    })
+}
+
+/// Starting position of game `index`: the seed corpus is cycled through in
+/// game order, the standard starting position stands in for an empty corpus.
+pub(crate) fn start_position(starts: &[Position], index: usize) -> Position {
+    if starts.is_empty() {
+        Position::starting()
+    } else {
+        starts[index % starts.len()].clone()
+    }
+}
+
+/// Plays one game to completion. Deterministic for a given `seed` and
+/// configuration: the search is single-threaded and the opening sampling
+/// uses a seeded generator.
+pub(crate) fn play_game(config: &Config, start: &Position, seed: u64) -> GameRecord {
+    let start_fen = if start.hash() == Position::starting().hash() {
+        None
+    } else {
+        Some(start.to_string())
+    };
+    let mut position = start.clone();
+    let mut searcher = Searcher::new(config.arena_mb);
+    let stop = AtomicBool::new(false);
+    let limits = Limits::nodes(config.simulations);
+    let mut rng = seed.wrapping_mul(0x9E37_79B9_7F4A_7C15).wrapping_add(1);
+    let mut plies = Vec::new();
+    let outcome = loop {
+        match position.game_status() {
+            GameStatus::Ongoing => {},
+            GameStatus::Checkmate if position.side_to_move() == Player::White => break -1,
+            GameStatus::Checkmate => break 1,
+            _ => break 0,
+        }
+        if plies.len() >= config.max_plies {
+            break 0;
+        }
+        let best = searcher
+            .search(&position, &limits, 1, &stop)
+            .expect("ongoing positions have moves to search");
+        let visits = searcher.root_visits();
+        let chosen = if plies.len() < TEMPERATURE_PLIES {
+            sample_by_visits(&visits, &mut rng).unwrap_or(best)
+        } else {
+            best
+        };
+        plies.push(PlyRecord {
+            next_move: chosen,
+            policy: visits
+                .iter()
+                .map(|&(next_move, count)| (next_move, count.min(u32::from(u16::MAX)) as u16))
+                .collect(),
+        });
+        searcher.advance(&position, &chosen);
+        position.make_move(&chosen);
+    };
+    GameRecord {
+        start_fen,
+        outcome,
+        plies,
+    }
+}
+
+/// Samples a move proportionally to its visit count.
+fn sample_by_visits(visits: &[(Move, u32)], rng: &mut u64) -> Option<Move> {
+    let total: u64 = visits.iter().map(|&(_, count)| u64::from(count)).sum();
+    if total == 0 {
+        return None;
+    }
+    let mut remaining = xorshift(rng) % total;
+    for &(next_move, count) in visits {
+        let count = u64::from(count);
+        if remaining < count {
+            return Some(next_move);
+        }
+        remaining -= count;
+    }
+    None
+}
+
+fn xorshift(state: &mut u64) -> u64 {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    *state
+}
+
+/// Streams encoded games into `games-NNNNN.bin` files, starting a new shard
+/// once the current one grows past the configured size. Shards are
+/// self-contained (games never straddle a boundary), so training jobs can
+/// shuffle and distribute them independently.
+struct ShardWriter {
+    directory: PathBuf,
+    shard_bytes: usize,
+    current: Option<BufWriter<fs::File>>,
+    written: usize,
+    shards: usize,
+}
+
+impl ShardWriter {
+    fn new(directory: &Path, shard_bytes: usize) -> Self {
+        Self {
+            directory: directory.to_path_buf(),
+            shard_bytes: shard_bytes.max(1),
+            current: None,
+            written: 0,
+            shards: 0,
+        }
+    }
+
+    fn write(&mut self, encoded: &[u8]) -> anyhow::Result<()> {
+        if self.current.is_none() || self.written >= self.shard_bytes {
+            self.roll()?;
+        }
+        let shard = self
+            .current
+            .as_mut()
+            .expect("roll() always leaves an open shard");
+        shard.write_all(encoded).context("can not write shard")?;
+        self.written += encoded.len();
+        Ok(())
+    }
+
+    fn roll(&mut self) -> anyhow::Result<()> {
+        self.flush()?;
+        let path = self.directory.join(format!("games-{:05}.bin", self.shards));
+        let file = fs::File::create(&path)
+            .with_context(|| format!("can not create shard {}", path.display()))?;
+        self.current = Some(BufWriter::new(file));
+        self.written = 0;
+        self.shards += 1;
+        Ok(())
+    }
+
+    fn flush(&mut self) -> anyhow::Result<()> {
+        if let Some(mut shard) = self.current.take() {
+            shard.flush().context("can not flush shard")?;
+        }
+        Ok(())
+    }
+
+    fn finish(mut self) -> anyhow::Result<usize> {
+        self.flush()?;
+        Ok(self.shards)
+    }
+}
@@ -1,6 +1,13 @@
 //! Convenient utility functions for Pabi that can be used from benchmarks and
 //! public tests.
 
+use std::fs;
+use std::path::Path;
+
+use anyhow::Context;
+
+use crate::chess::position::Position;
+
 // TODO: Docs.
 #[must_use]
 pub fn sanitize_fen(position: &str) -> String {
@@ -17,3 +24,72 @@ pub fn sanitize_fen(position: &str) -> String {
         _ => unreachable!(),
     }
 }
+
+/// A memory-mapped corpus of chess positions in FEN or EPD format, one per
+/// line (the shape of `data/positions.fen` and the position books used for
+/// training and benchmarking). Positions are parsed by
+/// [`Position::from_ascii`] straight out of the mapped bytes: no per-line
+/// `String` is materialized, so bulk-loading millions of positions is limited
+/// by the parser, not by I/O and the allocator.
+pub struct Corpus {
+    map: memmap2::Mmap,
+}
+
+impl Corpus {
+    /// Maps the corpus file into memory.
+    ///
+    /// # Errors
+    ///
+    /// Returns an error if the file can not be opened or mapped.
+    pub fn open(path: impl AsRef<Path>) -> anyhow::Result<Self> {
+        let file = fs::File::open(path.as_ref())
+            .with_context(|| format!("can not open corpus {}", path.as_ref().display()))?;
+        // SAFETY: the mapping is read-only; corpus files are not expected to
+        // be mutated while the engine reads them.
+        let map = unsafe { memmap2::Mmap::map(&file) }
+            .with_context(|| format!("can not map corpus {}", path.as_ref().display()))?;
+        Ok(Self { map })
+    }
+
+    /// Iterates over the positions in the corpus in file order. Empty lines
+    /// are skipped; malformed ones are yielded as errors so that the caller
+    /// decides whether to skip or abort.
+    #[must_use]
+    pub fn positions(&self) -> Positions<'_> {
+        Positions { rest: &self.map }
+    }
+}
+
+/// Streaming iterator over the lines of a [`Corpus`] parsed as [`Position`]s.
+pub struct Positions<'a> {
+    rest: &'a [u8],
+}
+
+impl Iterator for Positions<'_> {
+    type Item = anyhow::Result<Position>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        loop {
+            if self.rest.is_empty() {
+                return None;
+            }
+            let line = match self.rest.iter().position(|&byte| byte == b'\n') {
+                Some(end) => {
+                    let line = &self.rest[..end];
+                    self.rest = &self.rest[end + 1..];
+                    line
+                },
+                None => {
+                    let line = self.rest;
+                    self.rest = &[];
+                    line
+                },
+            };
+            let line = line.trim_ascii();
+            if line.is_empty() {
+                continue;
+            }
+            return Some(Position::from_ascii(line));
+        }
+    }
+}
@@ -1,8 +1,8 @@
 use std::fs;
 
 use itertools::Itertools;
-use pabi::chess::core::{Move, Promotion, Square};
-use pabi::chess::position::{perft, Position};
+use pabi::chess::core::{Move, Player, Promotion, Square};
+use pabi::chess::position::{perft, perft_parallel, Position};
 use pabi::util;
 use pretty_assertions::assert_eq;
 use shakmaty::{CastlingMode, Chess, Position as ShakmatyPosition};
@@ -174,6 +174,29 @@ fn arbitrary_positions() {
     }
 }
 
+// This test is very expensive in the Debug setting (could take 200+ seconds):
+// disable it by default.
+#[ignore]
+#[test]
+fn corpus_streaming() {
+    let path = concat!(env!("CARGO_MANIFEST_DIR"), "/data/positions.fen");
+    let corpus = util::Corpus::open(path).unwrap();
+    let mut count = 0;
+    for position in corpus.positions() {
+        let position = position.unwrap();
+        assert!(position.is_legal());
+        count += 1;
+    }
+    assert_eq!(
+        count,
+        fs::read_to_string(path)
+            .unwrap()
+            .lines()
+            .filter(|line| !line.trim().is_empty())
+            .count()
+    );
+}
+
 fn setup(input: &str) -> Position {
     Position::try_from(input).expect("parsing legal position: {input}")
 }
@@ -459,7 +482,9 @@ fn random_positions() {
     {
         let position = Position::from_fen(serialized_position).unwrap();
         let shakmaty_setup: shakmaty::fen::Fen = serialized_position.parse().unwrap();
-        let shakmaty_position: Chess = shakmaty_setup.position(CastlingMode::Standard).unwrap();
+        let shakmaty_position: Chess = shakmaty_setup
+            .into_position(CastlingMode::Standard)
+            .unwrap();
         let moves = position.generate_moves();
         assert_eq!(
             moves
@@ -520,6 +545,283 @@ fn castling_reset() {
     assert_eq!(position.fen(), "R3k2r/8/8/8/8/8/8/4K2R b Kk - 0 1");
 }
 
+#[test]
+fn staged_moves_generation() {
+    // The capture and quiet stages are disjoint and together yield exactly
+    // the full legal move list.
+    for fen in [
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "2r3r1/3p3k/1p3pp1/1B5P/5P2/2P1pqP1/PP4KP/3R4 w - - 0 34",
+        "8/8/8/8/8/8/6k1/4K2R w K - 0 1",
+    ] {
+        let position = setup(fen);
+        let staged = position
+            .generate_captures()
+            .iter()
+            .chain(position.generate_quiets().iter())
+            .map(Move::to_string)
+            .sorted()
+            .collect::<Vec<_>>();
+        assert_eq!(staged, get_moves(&position), "{fen}");
+    }
+    // Kiwipete has exactly 8 captures at depth 1.
+    let kiwipete = setup("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    assert_eq!(kiwipete.generate_captures().len(), 8);
+}
+
+#[test]
+fn evasions_generation() {
+    // While in check, every legal move is an evasion.
+    let position = setup("2r3r1/3p3k/1p3pp1/1B5P/5P2/2P1pqP1/PP4KP/3R4 w - - 0 34");
+    let evasions = position
+        .generate_evasions()
+        .iter()
+        .map(Move::to_string)
+        .sorted()
+        .collect::<Vec<_>>();
+    assert_eq!(evasions, get_moves(&position));
+}
+
+#[test]
+fn unmake_moves() {
+    let mut position = setup("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    position.make_move(&Move::new(Square::E2, Square::E4, None));
+    position.make_move(&Move::new(Square::E7, Square::E5, None));
+    position.make_move(&Move::new(Square::G1, Square::F3, None));
+    position.unmake_move();
+    position.unmake_move();
+    position.unmake_move();
+    assert_eq!(
+        position.fen(),
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+    );
+}
+
+#[test]
+fn unmake_special_moves() {
+    // Castling on both sides, captures resetting castling rights.
+    for (fen, moves) in [
+        (
+            "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1",
+            vec![
+                Move::new(Square::E1, Square::G1, None),
+                Move::new(Square::E8, Square::C8, None),
+            ],
+        ),
+        (
+            "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1",
+            vec![Move::new(Square::A1, Square::A8, None)],
+        ),
+        // En passant capture.
+        (
+            "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 3",
+            vec![Move::new(Square::D4, Square::E3, None)],
+        ),
+        // Promotion with a capture.
+        (
+            "2n4k/1PP5/6K1/3Pp1Q1/3N4/3P4/P3R3/8 w - - 0 1",
+            vec![Move::new(Square::B7, Square::C8, Some(Promotion::Queen))],
+        ),
+    ] {
+        let mut position = setup(fen);
+        for next_move in &moves {
+            position.make_move(next_move);
+        }
+        for _ in &moves {
+            position.unmake_move();
+        }
+        assert_eq!(position.fen(), fen, "make/unmake did not round-trip");
+    }
+}
+
+#[test]
+fn incremental_hash() {
+    // The incrementally updated key has to match the one computed from
+    // scratch when the resulting position is re-parsed from FEN.
+    let mut position =
+        setup("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    for next_move in [
+        Move::new(Square::E1, Square::G1, None),
+        Move::new(Square::H3, Square::G2, None),
+        Move::new(Square::D5, Square::E6, None),
+        Move::new(Square::G2, Square::H1, Some(Promotion::Queen)),
+    ] {
+        position.make_move(&next_move);
+        assert_eq!(
+            position.hash(),
+            Position::from_fen(&position.fen()).unwrap().hash(),
+            "hash mismatch after {next_move} in {}",
+            position.fen()
+        );
+    }
+    // Transpositions reach the same key: the move counters are not hashed.
+    let mut shuffled = Position::starting();
+    for next_move in [
+        Move::new(Square::G1, Square::F3, None),
+        Move::new(Square::G8, Square::F6, None),
+        Move::new(Square::F3, Square::G1, None),
+        Move::new(Square::F6, Square::G8, None),
+    ] {
+        shuffled.make_move(&next_move);
+    }
+    assert_eq!(shuffled.hash(), Position::starting().hash());
+}
+
+#[test]
+fn threefold_repetition() {
+    let mut position = Position::starting();
+    let shuffle = [
+        Move::new(Square::G1, Square::F3, None),
+        Move::new(Square::G8, Square::F6, None),
+        Move::new(Square::F3, Square::G1, None),
+        Move::new(Square::F6, Square::G8, None),
+    ];
+    assert!(!position.is_threefold_repetition());
+    for next_move in &shuffle {
+        position.make_move(next_move);
+    }
+    // The starting position occurred twice so far: not a threefold yet.
+    assert!(!position.is_threefold_repetition());
+    for next_move in &shuffle {
+        position.make_move(next_move);
+    }
+    assert!(position.is_threefold_repetition());
+    position.unmake_move();
+    assert!(!position.is_threefold_repetition());
+}
+
+#[test]
+fn check_detection() {
+    assert!(!Position::starting().in_check());
+    assert!(setup("rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3").in_check());
+    // The cached checkers survive a make/unmake round-trip.
+    let mut position = setup("rnbqkbnr/pppp1ppp/8/4p3/6P1/5P2/PPPPP2P/RNBQKBNR b KQkq - 0 2");
+    assert!(!position.in_check());
+    position.make_move(&Move::new(Square::D8, Square::H4, None));
+    assert!(position.in_check());
+    position.unmake_move();
+    assert!(!position.in_check());
+}
+
+#[test]
+fn attack_map_stays_in_sync() {
+    // The incrementally repaired attack map has to match the one computed
+    // from scratch when the position is re-parsed from FEN, at every node of
+    // a small tree walk.
+    fn walk(position: &mut Position, depth: u8) {
+        let fresh = Position::from_fen(&position.fen()).unwrap();
+        for player in [Player::White, Player::Black] {
+            assert_eq!(
+                position.attacks_by(player),
+                fresh.attacks_by(player),
+                "attack map out of sync for {player:?} in {}",
+                position.fen()
+            );
+        }
+        if depth == 0 {
+            return;
+        }
+        for next_move in position.generate_moves() {
+            position.make_move(&next_move);
+            walk(position, depth - 1);
+            position.unmake_move();
+        }
+    }
+    for fen in [
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    ] {
+        walk(&mut setup(fen), 2);
+    }
+}
+
+#[test]
+fn static_exchange_evaluation() {
+    for (fen, next_move, expected) in [
+        // Winning a pawn with an undefended capture.
+        (
+            "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1",
+            Move::new(Square::E1, Square::E5, None),
+            100,
+        ),
+        // The full swap-off with x-rays (queens lined up behind minor
+        // pieces) nets a knight for a pawn: the classic losing capture.
+        (
+            "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1",
+            Move::new(Square::D3, Square::E5, None),
+            -200,
+        ),
+        // Grabbing a defended pawn with the queen.
+        (
+            "k3r3/8/8/4p3/8/8/4Q3/K7 w - - 0 1",
+            Move::new(Square::E2, Square::E5, None),
+            -800,
+        ),
+        // En passant: the victim is not on the destination square and the
+        // capturing pawn is immediately recaptured by the king.
+        (
+            "8/8/4k3/8/3pP3/8/4K3/8 b - e3 0 1",
+            Move::new(Square::D4, Square::E3, None),
+            0,
+        ),
+        // Promotion into a rook capture: the promoted queen is lost.
+        (
+            "4r3/P3k3/8/8/8/8/8/K7 w - - 0 1",
+            Move::new(Square::A7, Square::A8, Some(Promotion::Queen)),
+            -100,
+        ),
+        // Quiet moves are supported, too: moving to a safe square is
+        // neutral.
+        (
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+            Move::new(Square::E2, Square::E4, None),
+            0,
+        ),
+    ] {
+        let position = setup(fen);
+        assert_eq!(
+            position.see(&next_move),
+            expected,
+            "SEE mismatch for {next_move} in {fen}"
+        );
+    }
+}
+
+#[test]
+fn gives_check_matches_make_move() {
+    // gives_check has a separate code path for each piece kind plus
+    // discovered, castling and en passant checks: cross-check it against the
+    // ground truth of actually making each legal move in a set of positions
+    // exercising all of them.
+    for fen in [
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        // Castling delivers a rook check.
+        "5k2/8/8/8/8/8/8/4K2R w K - 0 1",
+        // En passant opens a discovered check.
+        "8/8/8/2k5/3Pp3/8/8/4K2R b K d3 0 1",
+    ] {
+        let mut position = setup(fen);
+        for next_move in position.generate_moves() {
+            let predicted = position.gives_check(&next_move);
+            position.make_move(&next_move);
+            assert_eq!(
+                predicted,
+                position.in_check(),
+                "gives_check mismatch for {next_move} in {fen}"
+            );
+            position.unmake_move();
+        }
+    }
+}
+
 #[test]
 fn perft_starting_position() {
     let position = Position::starting();
@@ -548,6 +850,17 @@ fn perft_kiwipete() {
     assert_eq!(perft(&position, 3), 97862);
 }
 
+#[test]
+fn perft_parallel_matches_sequential() {
+    let position = setup("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    assert_eq!(perft_parallel(&position, 1, 4), 48);
+    assert_eq!(perft_parallel(&position, 3, 4), 97862);
+    assert_eq!(
+        perft_parallel(&Position::starting(), 4, 4),
+        perft(&Position::starting(), 4)
+    );
+}
+
 #[test]
 #[ignore]
 fn perft_kiwipete_expensive() {
@@ -629,3 +942,64 @@ fn perft_sixth_expensive() {
     assert_eq!(perft(&position, 4), 3894594);
     assert_eq!(perft(&position, 5), 164075551);
 }
+
+#[test]
+fn insufficient_material() {
+    // Bare kings, a lone minor piece and same-colored bishops can never
+    // mate.
+    for fen in [
+        "8/4k3/8/8/8/3K4/8/8 w - - 0 1",
+        "8/4k3/8/8/8/3KB3/8/8 w - - 0 1",
+        "8/4k3/8/8/8/3KN3/8/8 b - - 0 1",
+        // Three bishops, both players, all on dark squares.
+        "8/4k3/5b2/8/1B6/3K4/3B4/8 w - - 0 1",
+    ] {
+        assert!(setup(fen).has_insufficient_material(), "{fen}");
+    }
+    // A pawn, a rook, a minor pair or opposite-colored bishops keep mate
+    // possible.
+    for fen in [
+        "8/4k3/8/8/4P3/3K4/8/8 w - - 0 1",
+        "8/4k3/8/8/8/3KR3/8/8 w - - 0 1",
+        "8/4k3/8/8/8/3KBN2/8/8 w - - 0 1",
+        "8/4k3/8/8/8/3KBB2/8/8 w - - 0 1",
+    ] {
+        assert!(!setup(fen).has_insufficient_material(), "{fen}");
+    }
+}
+
+#[test]
+fn game_status() {
+    use pabi::chess::position::GameStatus;
+
+    // Fool's mate: white is checkmated.
+    assert_eq!(
+        setup("rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3").game_status(),
+        GameStatus::Checkmate
+    );
+    assert_eq!(
+        setup("k7/8/1Q6/8/8/8/8/K7 b - - 0 1").game_status(),
+        GameStatus::Stalemate
+    );
+    // A mate available on the board does not override an expired clock: the
+    // hundredth reversible halfmove already ended the game.
+    assert_eq!(
+        setup("7k/8/6K1/8/8/8/8/R7 w - - 100 80").game_status(),
+        GameStatus::DrawByFiftyMoveRule
+    );
+    assert_eq!(
+        setup("8/4k3/8/8/8/3KB3/8/8 w - - 0 1").game_status(),
+        GameStatus::DrawByInsufficientMaterial
+    );
+    assert_eq!(Position::starting().game_status(), GameStatus::Ongoing);
+    // Shuffling the knights back and forth twice brings up the starting
+    // position for the third time.
+    let mut position = Position::starting();
+    for _ in 0..2 {
+        position.make_move(&Move::new(Square::G1, Square::F3, None));
+        position.make_move(&Move::new(Square::G8, Square::F6, None));
+        position.make_move(&Move::new(Square::F3, Square::G1, None));
+        position.make_move(&Move::new(Square::F6, Square::G8, None));
+    }
+    assert_eq!(position.game_status(), GameStatus::DrawByRepetition);
+}
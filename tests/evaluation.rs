@@ -0,0 +1,121 @@
+use pabi::chess::position::Position;
+use pabi::evaluation::batch::{BatchEvaluator, BatchService};
+use pabi::evaluation::evaluator::Evaluator;
+use pabi::evaluation::nnue::{Network, Nnue};
+
+// Deterministic pseudo-random weights: small enough that the 16-bit
+// accumulator can not overflow with 32 pieces on the board.
+fn test_network() -> Network {
+    let mut state = 0x9E37_79B9_7F4A_7C15_u64;
+    let mut bytes = Vec::with_capacity(Network::SIZE_BYTES);
+    while bytes.len() < Network::SIZE_BYTES {
+        state = state
+            .wrapping_mul(6_364_136_223_846_793_005)
+            .wrapping_add(1_442_695_040_888_963_407);
+        let weight = ((state >> 33) % 63) as i16 - 31;
+        bytes.extend_from_slice(&weight.to_le_bytes());
+    }
+    Network::from_bytes(&bytes).unwrap()
+}
+
+fn assert_incremental_matches_scratch(
+    position: &mut Position,
+    incremental: &mut Nnue,
+    network: &Network,
+    depth: u8,
+) {
+    let mut scratch = Nnue::new(network.clone());
+    scratch.reset(position);
+    assert_eq!(
+        incremental.evaluate(position),
+        scratch.evaluate(position),
+        "accumulator out of sync at {}",
+        position.fen()
+    );
+    if depth == 0 {
+        return;
+    }
+    for next_move in position.generate_moves().iter() {
+        incremental.make_move(position, next_move);
+        position.make_move(next_move);
+        assert_incremental_matches_scratch(position, incremental, network, depth - 1);
+        position.unmake_move();
+        incremental.unmake_move();
+    }
+}
+
+#[test]
+fn incremental_accumulator_matches_scratch() {
+    let network = test_network();
+    for fen in [
+        // Kiwipete: castling in all directions, checks, promotions.
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        // Promotions with captures.
+        "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+        // En passant in the air.
+        "8/8/4k3/8/2pPp3/8/B7/7K b - d3 0 1",
+    ] {
+        let mut position = Position::from_fen(fen).unwrap();
+        let mut incremental = Nnue::new(network.clone());
+        incremental.reset(&position);
+        assert_incremental_matches_scratch(&mut position, &mut incremental, &network, 2);
+    }
+}
+
+#[test]
+fn zeroed_network_evaluates_to_zero() {
+    let mut evaluator = Nnue::new(Network::zeroed());
+    let position = Position::starting();
+    evaluator.reset(&position);
+    assert_eq!(evaluator.evaluate(&position), 0);
+}
+
+#[test]
+fn network_size_is_validated() {
+    assert!(Network::from_bytes(&[0; 64]).is_err());
+}
+
+struct PawnCounter;
+
+impl BatchEvaluator for PawnCounter {
+    fn evaluate_batch(&mut self, positions: &[Position]) -> Vec<i32> {
+        positions
+            .iter()
+            .map(|position| {
+                position.piece_count(position.side_to_move(), pabi::chess::core::PieceKind::Pawn)
+                    as i32
+            })
+            .collect()
+    }
+}
+
+#[test]
+fn batch_service_distributes_results() {
+    let service = BatchService::new(PawnCounter, 16);
+    let positions = [
+        ("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 8),
+        ("rnbqkbnr/pppppppp/8/8/8/8/PPPPPP2/RNBQKBNR w KQkq - 0 1", 6),
+        ("4k3/8/8/8/8/8/8/4K3 w - - 0 1", 0),
+        ("4k3/pppppppp/8/8/8/8/8/4K3 b - - 0 1", 8),
+    ];
+    // Submit from many threads at once: requests coalesce into batches and
+    // every submitter gets its own result back.
+    std::thread::scope(|scope| {
+        for _ in 0..8 {
+            let _ = scope.spawn(|| {
+                for (fen, pawns) in positions {
+                    let position = Position::from_fen(fen).unwrap();
+                    let pending = service.submit(position);
+                    assert_eq!(pending.wait(), pawns);
+                }
+            });
+        }
+    });
+}
+
+#[test]
+fn batch_service_drives_nnue() {
+    let service = BatchService::new(Nnue::new(Network::zeroed()), 4);
+    let pending = service.submit(Position::starting());
+    assert_eq!(pending.wait(), 0);
+}
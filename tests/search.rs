@@ -0,0 +1,156 @@
+use std::sync::atomic::AtomicBool;
+use std::time::{Duration, Instant};
+
+use pabi::chess::position::Position;
+use pabi::search::mcts::{Limits, Searcher};
+
+#[test]
+fn finds_mate_in_one() {
+    let position = Position::from_fen("7k/8/6K1/8/8/8/8/R7 w - - 0 1").unwrap();
+    let mut searcher = Searcher::new(16);
+    let best = searcher.search(&position, &Limits::nodes(5000), 1, &AtomicBool::new(false)).unwrap();
+    assert_eq!(best.to_string(), "a1a8");
+}
+
+#[test]
+fn grabs_hanging_queen() {
+    let position = Position::from_fen("k7/8/8/3q4/4P3/8/8/K7 w - - 0 1").unwrap();
+    let mut searcher = Searcher::new(16);
+    let best = searcher.search(&position, &Limits::nodes(5000), 1, &AtomicBool::new(false)).unwrap();
+    assert_eq!(best.to_string(), "e4d5");
+}
+
+#[test]
+fn parallel_search_converges() {
+    // The exact visit distribution is not deterministic with several threads,
+    // but a forced mate should dominate the root statistics regardless of the
+    // interleaving.
+    let position = Position::from_fen("7k/8/6K1/8/8/8/8/R7 w - - 0 1").unwrap();
+    let mut searcher = Searcher::new(16);
+    let best = searcher.search(&position, &Limits::nodes(20_000), 4, &AtomicBool::new(false)).unwrap();
+    assert_eq!(best.to_string(), "a1a8");
+}
+
+#[test]
+fn no_move_in_terminal_position() {
+    let mut searcher = Searcher::new(1);
+    // Fool's mate: white is checkmated and has no moves to pick from.
+    let mated =
+        Position::from_fen("rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3")
+            .unwrap();
+    assert!(mated.in_check());
+    assert!(mated.generate_moves().is_empty());
+    assert!(searcher.search(&mated, &Limits::nodes(100), 1, &AtomicBool::new(false)).is_none());
+    let stalemate = Position::from_fen("k7/8/1Q6/8/8/8/8/K7 b - - 0 1").unwrap();
+    assert!(stalemate.generate_moves().is_empty());
+    assert!(searcher.search(&stalemate, &Limits::nodes(100), 1, &AtomicBool::new(false)).is_none());
+}
+
+#[test]
+fn advance_retains_subtree() {
+    let mut position = Position::starting();
+    let mut searcher = Searcher::new(16);
+    let best = searcher.search(&position, &Limits::nodes(2000), 1, &AtomicBool::new(false)).unwrap();
+    searcher.advance(&position, &best);
+    position.make_move(&best);
+    // The played move's subtree survived: even with a zero budget the tree
+    // still holds the statistics to pick a reply from.
+    assert!(searcher.search(&position, &Limits::nodes(0), 1, &AtomicBool::new(false)).is_some());
+    // A position the tree was not built for yields nothing without a budget...
+    let unrelated =
+        Position::from_fen("r1bqkbnr/pppppppp/2n5/8/3P4/8/PPP1PPPP/RNBQKBNR w KQkq - 1 2")
+            .unwrap();
+    assert!(searcher.search(&unrelated, &Limits::nodes(0), 1, &AtomicBool::new(false)).is_none());
+    // ...and searching it normally drops the stale tree and works as usual.
+    assert!(searcher.search(&unrelated, &Limits::nodes(1000), 1, &AtomicBool::new(false)).is_some());
+}
+
+#[test]
+fn advance_through_unexplored_move_drops_tree() {
+    let mut position = Position::starting();
+    let mut searcher = Searcher::new(16);
+    let _ = searcher.search(&position, &Limits::nodes(100), 1, &AtomicBool::new(false)).unwrap();
+    let reply = position.generate_moves()[0].clone();
+    searcher.advance(&position, &reply);
+    position.make_move(&reply);
+    // Whether or not the subtree existed, the searcher must stay coherent
+    // with the game.
+    assert!(searcher.search(&position, &Limits::nodes(1000), 1, &AtomicBool::new(false)).is_some());
+}
+
+#[test]
+fn hard_deadline_cuts_an_unbounded_search() {
+    let position = Position::starting();
+    let mut searcher = Searcher::new(16);
+    let mut limits = Limits::nodes(usize::MAX);
+    limits.hard_deadline = Some(Instant::now() + Duration::from_millis(100));
+    let start = Instant::now();
+    assert!(searcher
+        .search(&position, &limits, 2, &AtomicBool::new(false))
+        .is_some());
+    // The deadline is polled every couple hundred simulations, so allow for
+    // generous overshoot on an unoptimized build.
+    assert!(start.elapsed() < Duration::from_secs(10));
+}
+
+#[test]
+fn predicts_a_reply_for_pondering() {
+    let mut position = Position::starting();
+    let mut searcher = Searcher::new(16);
+    let best = searcher
+        .search(&position, &Limits::nodes(2000), 1, &AtomicBool::new(false))
+        .unwrap();
+    // The principal line is two plies deep at this budget: the predicted
+    // reply must be a legal answer to the best move.
+    let reply = searcher.best_reply(&best).unwrap();
+    position.make_move(&best);
+    assert!(position
+        .generate_moves()
+        .iter()
+        .any(|next_move| *next_move == reply));
+}
+
+#[test]
+fn tablebases_are_discovered_and_probed() {
+    use pabi::search::syzygy::{Tablebases, Wdl};
+
+    let directory = std::env::temp_dir().join(format!("pabi-syzygy-{}", std::process::id()));
+    std::fs::create_dir_all(&directory).unwrap();
+    // The WDL magic followed by padding: enough for discovery, nothing to
+    // decode.
+    let stub = [0x71, 0xE8, 0x23, 0x5D, 0, 0, 0, 0];
+    std::fs::write(directory.join("KBvK.rtbw"), stub).unwrap();
+    std::fs::write(directory.join("KQvKR.rtbw"), stub).unwrap();
+    // A file without the magic is a broken download, not a table.
+    std::fs::write(directory.join("KRvK.rtbw"), [0u8; 8]).unwrap();
+    let tablebases = Tablebases::open(&directory).unwrap();
+    assert_eq!(tablebases.max_men(), 4);
+    // KBvK is drawn by insufficient material: the one value the probe can
+    // already produce without the block decoder.
+    let drawn = Position::from_fen("8/8/8/3k4/8/2B5/3K4/8 w - - 0 1").unwrap();
+    assert_eq!(tablebases.probe_wdl(&drawn), Some(Wdl::Draw));
+    // Flipped colors reach the same table.
+    let flipped = Position::from_fen("8/3k4/2b5/8/8/8/3K4/8 w - - 0 1").unwrap();
+    assert_eq!(tablebases.probe_wdl(&flipped), Some(Wdl::Draw));
+    // A nonzero halfmove clock gates the probe: the stored values assume a
+    // fresh fifty-move clock.
+    let clock_running = Position::from_fen("8/8/8/3k4/8/2B5/3K4/8 w - - 12 40").unwrap();
+    assert!(tablebases.probe_wdl(&clock_running).is_none());
+    // KQvKR is mapped but not decodable yet; KPvK has no table at all.
+    let undecoded = Position::from_fen("8/8/8/3k4/8/2Q5/1r1K4/8 w - - 0 1").unwrap();
+    assert!(tablebases.probe_wdl(&undecoded).is_none());
+    let uncovered = Position::from_fen("8/8/8/3k4/8/2P5/3K4/8 w - - 0 1").unwrap();
+    assert!(tablebases.probe_wdl(&uncovered).is_none());
+    // Too many men: out of tablebase territory.
+    assert!(tablebases.probe_wdl(&Position::starting()).is_none());
+    std::fs::remove_dir_all(&directory).unwrap();
+}
+
+#[test]
+fn tiny_arena_does_not_crash() {
+    // An arena that can not fit the tree degrades into evaluating leaves in
+    // place instead of failing.
+    let position = Position::starting();
+    let mut searcher = Searcher::new(1);
+    assert!(searcher.search(&position, &Limits::nodes(10_000), 2, &AtomicBool::new(false)).is_some());
+}
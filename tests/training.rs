@@ -0,0 +1,159 @@
+use std::fs;
+use std::net::TcpListener;
+
+use pabi::chess::core::Move;
+use pabi::chess::position::Position;
+use pabi::training::cluster;
+use pabi::training::data::{GameRecord, PlyRecord};
+use pabi::training::selfplay::{self, Config};
+
+#[test]
+fn game_record_roundtrip() {
+    let position = Position::starting();
+    let moves = position.generate_moves();
+    let record = GameRecord {
+        start_fen: None,
+        outcome: 1,
+        plies: vec![PlyRecord {
+            next_move: moves[0],
+            policy: moves.iter().map(|next_move| (*next_move, 7u16)).collect(),
+        }],
+    };
+    let mut encoded = Vec::new();
+    record.encode(&mut encoded);
+    let mut bytes = encoded.as_slice();
+    let decoded = GameRecord::decode(&mut bytes).unwrap();
+    assert!(bytes.is_empty());
+    assert_eq!(decoded.outcome, 1);
+    assert_eq!(decoded.plies.len(), 1);
+    assert_eq!(decoded.plies[0].next_move, record.plies[0].next_move);
+    assert_eq!(decoded.plies[0].policy, record.plies[0].policy);
+}
+
+#[test]
+fn decoding_rejects_truncated_records() {
+    let record = GameRecord {
+        start_fen: Some("7k/8/6K1/8/8/8/8/R7 w - - 0 1".to_string()),
+        outcome: 0,
+        plies: Vec::new(),
+    };
+    let mut encoded = Vec::new();
+    record.encode(&mut encoded);
+    let mut truncated = &encoded[..encoded.len() - 1];
+    assert!(GameRecord::decode(&mut truncated).is_err());
+}
+
+#[test]
+fn replay_rejects_illegal_moves() {
+    let record = GameRecord {
+        start_fen: None,
+        // e2e5 does not exist in the starting position.
+        outcome: 0,
+        plies: vec![PlyRecord {
+            next_move: Move::from_bits(
+                Position::starting()
+                    .generate_moves()
+                    .iter()
+                    .find(|next_move| next_move.to_string() == "e2e4")
+                    .unwrap()
+                    .bits(),
+            ),
+            policy: Vec::new(),
+        }],
+    };
+    // The legal move replays fine...
+    assert!(record.replay(|_, _| {}).is_ok());
+    // ...while a record claiming an impossible continuation does not.
+    let mut bogus = record.clone();
+    bogus.plies.push(bogus.plies[0].clone());
+    assert!(bogus.replay(|_, _| {}).is_err());
+}
+
+// Plays a handful of tiny-budget games end to end and replays every shard:
+// the whole pipeline (self-play, encoding, sharding) has to produce data the
+// loader accepts.
+#[test]
+fn generated_shards_replay_cleanly() {
+    let output = std::env::temp_dir().join(format!("pabi-selfplay-{}", std::process::id()));
+    let config = Config {
+        games: 4,
+        workers: 2,
+        simulations: 32,
+        arena_mb: 1,
+        max_plies: 40,
+        // Tiny shards force a rotation mid-run.
+        shard_bytes: 4096,
+        ..Config::default()
+    };
+    let summary = selfplay::generate(&config, &[], &output).unwrap();
+    assert_eq!(summary.games, 4);
+    assert!(summary.plies > 0);
+    assert!(summary.shards >= 1);
+    let mut replayed = 0u64;
+    for shard in 0..summary.shards {
+        let bytes = fs::read(output.join(format!("games-{shard:05}.bin"))).unwrap();
+        let mut rest = bytes.as_slice();
+        while !rest.is_empty() {
+            let record = GameRecord::decode(&mut rest).unwrap();
+            assert!((-1..=1).contains(&record.outcome));
+            record
+                .replay(|position, ply| {
+                    // The policy is over the legal moves of this position.
+                    assert!(!ply.policy.is_empty());
+                    assert!(position.generate_moves().len() >= ply.policy.len());
+                    replayed += 1;
+                })
+                .unwrap();
+        }
+    }
+    assert_eq!(replayed, summary.plies);
+    fs::remove_dir_all(&output).unwrap();
+}
+
+// End-to-end cluster run on loopback: a coordinator and two workers playing
+// tiny games. The dataset must come back complete, deduplicated and
+// decodable.
+#[test]
+fn cluster_run_produces_complete_dataset() {
+    let output = std::env::temp_dir().join(format!("pabi-cluster-{}", std::process::id()));
+    // Pick a free loopback port; the listener is dropped right before the
+    // coordinator binds it.
+    let address = {
+        let probe = TcpListener::bind("127.0.0.1:0").unwrap();
+        probe.local_addr().unwrap()
+    };
+    // Two batches' worth of games (BATCH_GAMES is 32).
+    let games = cluster::BATCH_GAMES + 8;
+    let config = Config {
+        games,
+        workers: 2,
+        simulations: 8,
+        arena_mb: 1,
+        max_plies: 10,
+        ..Config::default()
+    };
+    let shards = std::thread::scope(|scope| {
+        let coordinator = scope.spawn(|| cluster::coordinate(address, games, &output).unwrap());
+        // Give the listener a moment to come up before the workers dial in.
+        std::thread::sleep(std::time::Duration::from_millis(100));
+        for _ in 0..2 {
+            let config = &config;
+            let _ = scope.spawn(move || cluster::work(address, config, &[]).unwrap());
+        }
+        coordinator.join().unwrap()
+    });
+    assert_eq!(shards, 2);
+    let mut replayed_games = 0;
+    for shard in 0..shards {
+        let compressed = fs::read(output.join(format!("batch-{shard:05}.bin.gz"))).unwrap();
+        let decompressed = cluster::decompress_shard(&compressed).unwrap();
+        let mut rest = decompressed.as_slice();
+        while !rest.is_empty() {
+            let record = GameRecord::decode(&mut rest).unwrap();
+            record.replay(|_, _| {}).unwrap();
+            replayed_games += 1;
+        }
+    }
+    assert_eq!(replayed_games, games);
+    fs::remove_dir_all(&output).unwrap();
+}
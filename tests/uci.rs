@@ -0,0 +1,256 @@
+use std::io::Write;
+use std::sync::{Arc, Mutex};
+use std::time::Duration;
+
+use pabi::interface::uci::Engine;
+
+// Captures everything the engine sends, including responses printed
+// asynchronously by the search worker.
+#[derive(Clone, Default)]
+struct Transcript(Arc<Mutex<Vec<u8>>>);
+
+impl Transcript {
+    fn text(&self) -> String {
+        String::from_utf8(self.0.lock().unwrap().clone()).unwrap()
+    }
+}
+
+impl Write for Transcript {
+    fn write(&mut self, buf: &[u8]) -> std::io::Result<usize> {
+        self.0.lock().unwrap().extend_from_slice(buf);
+        Ok(buf.len())
+    }
+
+    fn flush(&mut self) -> std::io::Result<()> {
+        Ok(())
+    }
+}
+
+#[test]
+fn handshake() {
+    let transcript = Transcript::default();
+    let mut engine = Engine::new(Box::new(transcript.clone()));
+    assert!(engine.execute("uci"));
+    assert!(engine.execute("isready"));
+    let text = transcript.text();
+    assert!(text.contains("id name pabi"));
+    assert!(text.contains("option name Hash"));
+    assert!(text.contains("option name Threads"));
+    assert!(text.contains("uciok"));
+    assert!(text.ends_with("readyok\n"));
+}
+
+#[test]
+fn search_reports_bestmove() {
+    let transcript = Transcript::default();
+    let mut engine = Engine::new(Box::new(transcript.clone()));
+    // Mate in one: the search has no excuse to miss it.
+    assert!(engine.execute("position fen 7k/8/6K1/8/8/8/8/R7 w - - 0 1"));
+    assert!(engine.execute("setoption name Threads value 1"));
+    assert!(engine.execute("go nodes 5000"));
+    // The bestmove arrives asynchronously once the budget is spent.
+    for _ in 0..100 {
+        if transcript.text().contains("bestmove") {
+            break;
+        }
+        std::thread::sleep(Duration::from_millis(20));
+    }
+    assert!(transcript.text().contains("bestmove a1a8"));
+}
+
+#[test]
+fn stop_interrupts_infinite_search() {
+    let transcript = Transcript::default();
+    let mut engine = Engine::new(Box::new(transcript.clone()));
+    assert!(engine.execute("position startpos moves e2e4 e7e5"));
+    assert!(engine.execute("go infinite"));
+    // The reader stays responsive while the workers search.
+    assert!(engine.execute("isready"));
+    std::thread::sleep(Duration::from_millis(50));
+    assert!(!transcript.text().contains("bestmove"));
+    assert!(engine.execute("stop"));
+    assert!(transcript.text().contains("bestmove"));
+}
+
+#[test]
+fn ponder_holds_bestmove_until_ponderhit() {
+    let transcript = Transcript::default();
+    let mut engine = Engine::new(Box::new(transcript.clone()));
+    assert!(engine.execute("position startpos"));
+    assert!(engine.execute("go ponder"));
+    std::thread::sleep(Duration::from_millis(50));
+    assert!(!transcript.text().contains("bestmove"));
+    assert!(engine.execute("ponderhit"));
+    assert!(engine.execute("stop"));
+    assert!(transcript.text().contains("bestmove"));
+}
+
+#[test]
+fn clock_is_translated_into_a_deadline() {
+    let transcript = Transcript::default();
+    let mut engine = Engine::new(Box::new(transcript.clone()));
+    assert!(engine.execute("position startpos"));
+    // One second on the clock allocates a fraction of it: the bestmove must
+    // arrive on its own, well before the clock runs out.
+    assert!(engine.execute("go wtime 1000 btime 1000 winc 0 binc 0"));
+    for _ in 0..200 {
+        if transcript.text().contains("bestmove") {
+            break;
+        }
+        std::thread::sleep(Duration::from_millis(20));
+    }
+    assert!(transcript.text().contains("bestmove"));
+}
+
+#[test]
+fn ponderhit_arms_the_clock() {
+    let transcript = Transcript::default();
+    let mut engine = Engine::new(Box::new(transcript.clone()));
+    assert!(engine.execute("position startpos"));
+    assert!(engine.execute("go ponder wtime 1000 btime 1000"));
+    // On the opponent's time the search is unbounded.
+    std::thread::sleep(Duration::from_millis(50));
+    assert!(!transcript.text().contains("bestmove"));
+    // `ponderhit` starts our clock: the budget computed at `go` time now
+    // ends the search without any further GUI input.
+    assert!(engine.execute("ponderhit"));
+    for _ in 0..200 {
+        if transcript.text().contains("bestmove") {
+            break;
+        }
+        std::thread::sleep(Duration::from_millis(20));
+    }
+    assert!(transcript.text().contains("bestmove"));
+}
+
+#[test]
+fn perft_divide_matches_reference_counts() {
+    let transcript = Transcript::default();
+    let mut engine = Engine::new(Box::new(transcript.clone()));
+    assert!(engine.execute("position startpos"));
+    assert!(engine.execute("go perft 2"));
+    // The divide runs on the worker thread; joining the search waits for it.
+    engine.stop_search();
+    let text = transcript.text();
+    // Depth 2 from the starting position is uniform: every first move
+    // admits the same 20 replies.
+    assert!(text.contains("e2e4: 20"));
+    assert!(text.contains("g1f3: 20"));
+    assert!(text.contains("Nodes searched: 400"));
+}
+
+#[test]
+fn bench_reports_a_deterministic_signature() {
+    let transcript = Transcript::default();
+    let mut engine = Engine::new(Box::new(transcript.clone()));
+    // A tiny budget keeps the test fast: determinism does not depend on it.
+    assert!(engine.execute("bench 64"));
+    assert!(engine.execute("bench 64"));
+    let text = transcript.text();
+    assert!(text.contains("Total nodes:  1280"));
+    assert!(text.contains("Nodes/second:"));
+    let signatures: Vec<&str> = text
+        .lines()
+        .filter(|line| line.starts_with("Signature:"))
+        .collect();
+    assert_eq!(signatures.len(), 2);
+    assert_eq!(signatures[0], signatures[1]);
+}
+
+#[test]
+fn rejects_malformed_input() {
+    let transcript = Transcript::default();
+    let mut engine = Engine::new(Box::new(transcript.clone()));
+    assert!(engine.execute("position fen not a position"));
+    assert!(engine.execute("position startpos moves e2e5"));
+    assert!(engine.execute("flip the board"));
+    let text = transcript.text();
+    assert!(text.contains("info string invalid position"));
+    assert!(text.contains("info string illegal move: e2e5"));
+    assert!(text.contains("info string unknown command: flip"));
+    // `quit` asks the driver loop to exit.
+    assert!(!engine.execute("quit"));
+}
+
+// Builds a book in the Polyglot entry layout (big-endian, sorted by key)
+// keyed by the engine's own hashes.
+fn write_book(path: &std::path::Path, entries: &[(u64, u16, u16)]) {
+    let mut sorted = entries.to_vec();
+    sorted.sort_by_key(|&(key, _, _)| key);
+    let mut bytes = Vec::new();
+    for (key, raw_move, weight) in sorted {
+        bytes.extend_from_slice(&key.to_be_bytes());
+        bytes.extend_from_slice(&raw_move.to_be_bytes());
+        bytes.extend_from_slice(&weight.to_be_bytes());
+        bytes.extend_from_slice(&0u32.to_be_bytes());
+    }
+    std::fs::write(path, bytes).unwrap();
+}
+
+// Packs a move the way Polyglot does: to-file/to-row/from-file/from-row in
+// three bits each.
+fn polyglot_move(from_file: u16, from_row: u16, to_file: u16, to_row: u16) -> u16 {
+    to_file | to_row << 3 | from_file << 6 | from_row << 9
+}
+
+#[test]
+fn book_probe_picks_the_heaviest_legal_entry() {
+    use pabi::chess::position::Position;
+    use pabi::interface::book::Book;
+
+    let path = std::env::temp_dir().join(format!("pabi-book-{}.bin", std::process::id()));
+    let startpos = Position::starting();
+    let e2e4 = polyglot_move(4, 1, 4, 3);
+    let d2d4 = polyglot_move(3, 1, 3, 3);
+    write_book(
+        &path,
+        &[
+            (startpos.hash(), d2d4, 10),
+            (startpos.hash(), e2e4, 100),
+            // An entry that does not decode to a legal move is skipped.
+            (0x1234_5678, e2e4, 1),
+        ],
+    );
+    let book = Book::open(&path).unwrap();
+    assert_eq!(book.len(), 3);
+    assert_eq!(book.probe(&startpos).unwrap().to_string(), "e2e4");
+    let mut after = startpos.clone();
+    let reply = after
+        .generate_moves()
+        .iter()
+        .find(|next_move| next_move.to_string() == "e2e4")
+        .copied()
+        .unwrap();
+    after.make_move(&reply);
+    assert!(book.probe(&after).is_none());
+    std::fs::remove_file(&path).unwrap();
+}
+
+#[test]
+fn book_rejects_torn_files() {
+    use pabi::interface::book::Book;
+
+    let path = std::env::temp_dir().join(format!("pabi-badbook-{}.bin", std::process::id()));
+    std::fs::write(&path, [0u8; 17]).unwrap();
+    assert!(Book::open(&path).is_err());
+    std::fs::remove_file(&path).unwrap();
+}
+
+#[test]
+fn book_moves_bypass_the_search() {
+    use pabi::chess::position::Position;
+
+    let path = std::env::temp_dir().join(format!("pabi-uci-book-{}.bin", std::process::id()));
+    write_book(
+        &path,
+        &[(Position::starting().hash(), polyglot_move(4, 1, 4, 3), 1)],
+    );
+    let transcript = Transcript::default();
+    let mut engine = Engine::new(Box::new(transcript.clone()));
+    assert!(engine.execute(&format!("setoption name BookFile value {}", path.display())));
+    assert!(engine.execute("position startpos"));
+    assert!(engine.execute("go wtime 60000 btime 60000"));
+    // The bestmove is printed synchronously: no worker was spawned.
+    assert!(transcript.text().contains("bestmove e2e4"));
+    std::fs::remove_file(&path).unwrap();
+}